@@ -20,6 +20,9 @@
 		- all perform in quadratic time
 		- insertion sort and select sort have roughly the same running time
 		- bubble sort behaves the worst from the beginning, and gets worse
+	- generator_cases() runs the three sorts on the organ-pipe, sawtooth,
+	  few-unique and Zipf inputs of common/inputgen.h (series suffixed
+	  _o, _s, _f and _z)
 */
 
 /* I have added the following function in Profiler.h to ease dividing
@@ -35,6 +38,8 @@
 
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
+#include "../common/inputgen.h"
 #include <cstdio>
 #include <assert.h>
 
@@ -177,7 +182,7 @@ void best_case() {
 
 	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 			int arr[dim];
-			FillRandomArray(arr, dim,
+			rngFillArray(arr, dim,
 				RANGE_MIN, RANGE_MAX, false, ASCENDING);
 
 			int backup[dim];
@@ -209,7 +214,7 @@ void worst_case() {
 
 	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 			int arr[dim];
-			FillRandomArray(arr, dim,
+			rngFillArray(arr, dim,
 				RANGE_MIN, RANGE_MAX, false, DESCENDING);
 
 			int backup[dim];
@@ -240,7 +245,7 @@ void average_case() {
 	for (int rep=0; rep < AVG_CASE_TRIALS; rep++) {
 		for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 			int arr[dim];
-			FillRandomArray(arr, dim,
+			rngFillArray(arr, dim,
 				RANGE_MIN, RANGE_MAX, false, UNSORTED);
 
 			int backup[dim];
@@ -271,6 +276,47 @@ void average_case() {
 	profiler.showReport();
 }
 
+void generator_cases() {
+	char caseIds[] = { 'o', 's', 'f', 'z' };
+	char *groups[] = { "Total organ pipe", "Total sawtooth", "Total few unique", "Total zipf" };
+	char *series[][3] = {
+		{ "insert_sort_o", "select_sort_o", "bubble_sort_o" },
+		{ "insert_sort_s", "select_sort_s", "bubble_sort_s" },
+		{ "insert_sort_f", "select_sort_f", "bubble_sort_f" },
+		{ "insert_sort_z", "select_sort_z", "bubble_sort_z" } };
+
+	profiler.reset("generator-inputs");
+
+	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
+		int arr[dim], backup[dim];
+
+		for (int g=0; g < 4; g++) {
+			switch (g) {
+				case 0: genOrganPipe(backup, dim, RANGE_MIN, RANGE_MAX); break;
+				case 1: genSawtooth(backup, dim, 100, RANGE_MIN, RANGE_MAX); break;
+				case 2: genFewUnique(backup, dim, 10, RANGE_MIN, RANGE_MAX); break;
+				case 3: genZipf(backup, dim, RANGE_MIN, RANGE_MAX, 1.0); break;
+			}
+
+			copyValues(backup, arr, dim);
+			insert_sort(arr, dim, caseIds[g]);
+			assert(IsSorted(arr, dim));
+
+			copyValues(backup, arr, dim);
+			select_sort(arr, dim, caseIds[g]);
+			assert(IsSorted(arr, dim));
+
+			copyValues(backup, arr, dim);
+			bubble_sort(arr, dim, caseIds[g]);
+			assert(IsSorted(arr, dim));
+		}
+	}
+
+	for (int g=0; g < 4; g++)
+		profiler.createGroup(groups[g], series[g][0], series[g][1], series[g][2]);
+	profiler.showReport();
+}
+
 void demo() {
 
 	int arr[] = {41, 80, 82, 4, 34, 14, 58, 22, 23, 56, 3, 9};
@@ -303,6 +349,7 @@ void demo() {
 }
 
 int main(void) {
+	rngSeed(RNG_SEED);
 
 	demo();
 
@@ -312,5 +359,7 @@ int main(void) {
 
 	worst_case();
 
+	generator_cases();
+
 	return 0;
 }
\ No newline at end of file
@@ -12,6 +12,8 @@
 	  actually makes performance better than the average cases
 	- still, bottom up performs better, with a lower
 	  multiplicative constant.
+	- generator_cases() builds heaps and heapsorts the organ-pipe,
+	  sawtooth, few-unique and Zipf inputs of common/inputgen.h
 
 	 INTERPRETATION:
 	- the bottom up method is better suited for
@@ -24,6 +26,8 @@
 */
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
+#include "../common/inputgen.h"
 #include <cstdio>
 #include <climits>
 #include <cassert>
@@ -212,7 +216,7 @@ void average_case() {
 		for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 			// initialize working and backup array
 			int arr[dim];
-			FillRandomArray(arr, dim,
+			rngFillArray(arr, dim,
 				RANGE_MIN, RANGE_MAX, false, UNSORTED);
 
 			int backup[dim];
@@ -255,7 +259,7 @@ void worst_case() {
 	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 		// initialize working and backup array
 		int arr[dim];
-		FillRandomArray(arr, dim,
+		rngFillArray(arr, dim,
 			RANGE_MIN, RANGE_MAX, false, ASCENDING);
 
 		int backup[dim];
@@ -292,10 +296,55 @@ void worst_case() {
 
 }
 
+void generator_cases() {
+	char *series[][3] = {
+		{ "bottom_up_organPipe", "top_down_organPipe", "heapsort_organPipe" },
+		{ "bottom_up_sawtooth", "top_down_sawtooth", "heapsort_sawtooth" },
+		{ "bottom_up_fewUnique", "top_down_fewUnique", "heapsort_fewUnique" },
+		{ "bottom_up_zipf", "top_down_zipf", "heapsort_zipf" } };
+	char *groups[] = { "build_heap_organPipe", "build_heap_sawtooth", "build_heap_fewUnique", "build_heap_zipf" };
+
+	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
+		int arr[dim], backup[dim];
+
+		for (int g=0; g < 4; g++) {
+			switch (g) {
+				case 0: genOrganPipe(backup, dim, RANGE_MIN, RANGE_MAX); break;
+				case 1: genSawtooth(backup, dim, 100, RANGE_MIN, RANGE_MAX); break;
+				case 2: genFewUnique(backup, dim, 10, RANGE_MIN, RANGE_MAX); break;
+				case 3: genZipf(backup, dim, RANGE_MIN, RANGE_MAX, 1.0); break;
+			}
+
+			CopyArray(arr, backup, dim);
+			countOperations = 0;
+			build_max_heap_bu(arr, dim);
+			assert(validate_max_heap(0, arr, dim));
+			profiler.countOperation(series[g][0], dim, countOperations);
+
+			CopyArray(arr, backup, dim);
+			countOperations = 0;
+			build_max_heap_td(arr, dim);
+			assert(validate_max_heap(0, arr, dim));
+			profiler.countOperation(series[g][1], dim, countOperations);
+
+			CopyArray(arr, backup, dim);
+			countOperations = 0;
+			heap_sort(arr, dim);
+			assert(IsSorted(arr, dim));
+			profiler.countOperation(series[g][2], dim, countOperations);
+		}
+	}
+
+	for (int g=0; g < 4; g++)
+		profiler.createGroup(groups[g], series[g][0], series[g][1]);
+}
+
 int main() {
+	rngSeed(RNG_SEED);
 	demo();
 	average_case();
 	worst_case();
+	generator_cases();
 
 	profiler.createGroup("heapsort", "heapsort_average", "heapsort_worst");
 	profiler.showReport();
@@ -0,0 +1,226 @@
+/*	External merge sort for files of raw ints that do not fit in memory.
+
+	- run generation: the input is read in chunks of half the memory
+	  budget (the other half is left for the in-memory sort's scratch),
+	  each chunk is sorted with cfg->sortRun and appended to a run file;
+	  sortRun must free its scratch before it returns (quicksort_simd
+	  does), the chunk is freed before the merge passes, so they have
+	  the whole budget to themselves
+	- merge passes: up to fanIn runs are merged at a time through
+	  double-buffered block readers and a block writer (common/blockio.h),
+	  selection is a binary min-heap on the current head of each run
+	- fanIn and the block size both come from the budget:
+		2 blocks per reader + 2 for the writer <= memBudget
+	  so a small budget gives more passes instead of more memory
+	- runs of a pass live back to back in one temp file, passes ping-pong
+	  between two temp files and the last one writes outPath
+	- the temp files are unlinked as soon as they are created, so closing
+	  them is enough on every path; on an IO error the partial outPath is
+	  removed and externalSort returns false
+*/
+
+#ifndef EXTSORT_H
+#define EXTSORT_H
+
+#include "../common/blockio.h"
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <climits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define EXT_MIN_BLOCK_INTS (64 * 1024 / sizeof(int))
+
+typedef void (*RunSortFn)(int *A, int n);
+
+typedef struct {
+	int64_t memBudget;		// bytes
+	const char *tmpDir;
+	RunSortFn sortRun;		// may use memBudget/2 of scratch, freed before it returns
+
+	// filled in by externalSort
+	int64_t runs;
+	int passes;
+} ExtSortConfig;
+
+typedef struct {
+	int val;
+	int src;
+} ExtHeapNode;
+
+static void ext_min_heapify(ExtHeapNode *h, int n, int i) {
+	while (true) {
+		int smallest = i, l = 2*i + 1, r = 2*i + 2;
+
+		if (l < n && h[l].val < h[smallest].val)
+			smallest = l;
+		if (r < n && h[r].val < h[smallest].val)
+			smallest = r;
+
+		if (smallest == i)
+			return;
+
+		ExtHeapNode tmp = h[i];
+		h[i] = h[smallest];
+		h[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+// merges runs [first, first+k) of runOff/runLen into w, false if a read failed
+static bool ext_merge_group(int fd, std::vector<int64_t> &runOff, std::vector<int64_t> &runLen,
+		int first, int k, int blockInts, BlockWriter *w) {
+	BlockReader *readers = (BlockReader*) malloc(k * sizeof(BlockReader));
+	ExtHeapNode *heap = (ExtHeapNode*) malloc(k * sizeof(ExtHeapNode));
+	assert(readers != NULL && heap != NULL);
+	int n = 0;
+
+	for (int i=0; i < k; i++) {
+		readerOpen(&readers[i], fd, runOff[first + i], runLen[first + i], blockInts);
+		if (readerNext(&readers[i], &heap[n].val))
+			heap[n++].src = i;
+	}
+
+	for (int i = n/2 - 1; i >= 0; i--)
+		ext_min_heapify(heap, n, i);
+
+	while (n > 0) {
+		writerPut(w, heap[0].val);
+
+		if (!readerNext(&readers[heap[0].src], &heap[0].val))
+			heap[0] = heap[--n];
+
+		ext_min_heapify(heap, n, 0);
+	}
+
+	bool ok = true;
+	for (int i=0; i < k; i++)
+		ok = readerClose(&readers[i]) && ok;
+
+	free(readers);
+	free(heap);
+	return ok;
+}
+
+static int ext_temp_file(const char *dir, char *path) {
+	sprintf(path, "%s/extsort-XXXXXX", dir);
+	int fd = mkstemp(path);
+	if (fd >= 0)
+		unlink(path);	// removed on close
+
+	return fd;
+}
+
+// sorts the ints of inPath into outPath, false on IO errors
+bool externalSort(const char *inPath, const char *outPath, ExtSortConfig *cfg) {
+	assert(cfg != NULL && cfg->sortRun != NULL);
+	char path[4096];
+
+	int in = open(inPath, O_RDONLY);
+	if (in < 0) {
+		perror(inPath);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(in, &st) != 0) {
+		perror(inPath);
+		close(in);
+		return false;
+	}
+	int64_t total = st.st_size / sizeof(int);
+
+	int64_t chunkInts = cfg->memBudget / 2 / sizeof(int);
+	assert(chunkInts > 0 && chunkInts <= INT_MAX);
+
+	int tmp[2];
+	tmp[0] = ext_temp_file(cfg->tmpDir, path);
+	tmp[1] = ext_temp_file(cfg->tmpDir, path);
+	int out = open(outPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	bool ok = tmp[0] >= 0 && tmp[1] >= 0 && out >= 0;
+	if (!ok)
+		perror("externalSort");
+
+	// 1. run generation
+	std::vector<int64_t> runOff, runLen;
+	int *chunk = (int*) malloc(chunkInts * sizeof(int));
+	assert(chunk != NULL);
+	bool single = total <= chunkInts;
+	int dst = single ? out : tmp[0];
+
+	for (int64_t done=0; ok && done < total; done += chunkInts) {
+		int len;
+		int64_t n = total - done < chunkInts ? total - done : chunkInts;
+
+		ok = blockFill(in, chunk, &len, done * sizeof(int), n * sizeof(int));
+		if (!ok)
+			break;
+
+		cfg->sortRun(chunk, len);
+		ok = blockFlush(dst, chunk, n * sizeof(int), done * sizeof(int));
+
+		runOff.push_back(done * sizeof(int));
+		runLen.push_back(n * sizeof(int));
+	}
+
+	free(chunk);
+	close(in);
+	cfg->runs = runOff.size();
+	cfg->passes = 0;
+
+	// 2. merge passes
+	int src = 0;
+	while (ok && !single && runOff.size() > 1) {
+		int64_t blocks = cfg->memBudget / (int64_t) (EXT_MIN_BLOCK_INTS * sizeof(int));
+		int fanIn = (int) (blocks / 2 - 1);
+		if (fanIn < 2)
+			fanIn = 2;
+		if (fanIn > (int) runOff.size())
+			fanIn = runOff.size();
+
+		int blockInts = (int) (cfg->memBudget / (2 * (fanIn + 1)) / sizeof(int));
+		if (blockInts < (int) EXT_MIN_BLOCK_INTS)
+			blockInts = EXT_MIN_BLOCK_INTS;
+
+		bool last = (int) runOff.size() <= fanIn;
+		int to = last ? out : tmp[src ^ 1];
+		std::vector<int64_t> nextOff, nextLen;
+		int64_t offset = 0;
+
+		for (int first=0; ok && first < (int) runOff.size(); first += fanIn) {
+			int k = runOff.size() - first < (size_t) fanIn ? runOff.size() - first : fanIn;
+			BlockWriter w;
+
+			writerOpen(&w, to, offset, blockInts);
+			ok = ext_merge_group(tmp[src], runOff, runLen, first, k, blockInts, &w);
+			int64_t end = writerClose(&w);
+			ok = ok && end >= 0;
+
+			nextOff.push_back(offset);
+			nextLen.push_back(end - offset);
+			offset = end;
+		}
+
+		runOff.swap(nextOff);
+		runLen.swap(nextLen);
+		src ^= 1;
+		cfg->passes++;
+	}
+
+	for (int i=0; i < 2; i++)
+		if (tmp[i] >= 0)
+			close(tmp[i]);
+	if (out >= 0)
+		close(out);
+	if (!ok && out >= 0)
+		unlink(outPath);
+
+	return ok;
+}
+
+#endif
@@ -11,20 +11,58 @@
 	  average case
 	- the best case input for quicksort was found here:
 		https://stackoverflow.com/questions/35517172/what-is-the-best-input-array-for-quick-sort
-	- it involves using a balanced BST and using its postorder traversal
+	- it involves using a balanced BST and using its postorder traversal,
+	  genBestCasePO (common/inputgen.h) writes that order directly
+	- generator_cases() also runs both sorts on organ-pipe, sawtooth,
+	  few-unique and Zipf inputs, and randomized quicksort on McIlroy's
+	  adversary (replayed with the same rng seed, so it turns quadratic)
 	- quickselect is only verified for correctness in demo()
+	- radix sort (radix.h) is reported in the average case next to
+	  quicksort and heapsort; it does a constant number of linear passes,
+	  so its curve is a straight line
+	- sort_timing() compares wall time on large arrays, including the
+	  parallel MSD variant, which the operation counter cannot measure
+	- partition_simd (simd_partition.h) partitions a whole vector per
+	  step (AVX-512 / AVX2, scalar fallback) and plugs into
+	  quicksort_randomized (quicksort_simd); keys equal to the pivot are
+	  split between both sides, so few-unique inputs do not go quadratic;
+	  it is checked with IsSorted() on every generator input and timed
+	  in sort_timing()
+	- top-k: a bounded max-heap of size k (streaming) or quickselect
+	  followed by quicksort of the prefix (in memory); topk() picks the
+	  heap while k <= n/TOPK_HEAP_RATIO, where its n + k*log(k)*ln(n/k)
+	  cost is below the two linear passes of the select path,
+	  topk_cases() compares both against a full quicksort
+	- the largest k are found with the same code on ~x, which reverses
+	  the order of ints without overflowing like -x does on INT_MIN
+	- pair sorts keep keys and payloads in two arrays and move them
+	  together: partition and heapify above take the swap as a
+	  callback and the pair sorts pass pair_swap; argsort is a pair
+	  sort of a key copy with 32 bit indices as payload, so records are
+	  gathered once at the end instead of being moved at every swap,
+	  record_sort_benchmark() compares both on 64 and 256 byte records
+	- externalSort (extsort.h) sorts files larger than memory: runs are
+	  sorted with quicksort_simd, then merged k at a time with
+	  double-buffered block IO; external_sort_benchmark() sorts a
+	  generated file under shrinking memory budgets, which only adds
+	  merge passes
 
 	 INTERPRETATION:
 	- quicksort with random pivot is a faster general use sorting algorithm
 */
 
 #include "profiler/Profiler.h"
-#include "bst.h"
+#include "../common/rng.h"
+#include "../common/inputgen.h"
+#include "radix.h"
+#include "simd_partition.h"
+#include "extsort.h"
 #include <cstdio>
 #include <cstdlib>
 #include <climits>
 #include <cassert>
 #include <cmath>
+#include <chrono>
 
 #define AVG_CASE_TRIALS 5
 #define DIM_MIN 10
@@ -33,6 +71,14 @@
 #define RANGE_MIN 1
 #define RANGE_MAX 100000
 
+#define EXT_SORT_INTS (1 << 26)		// 256 MB input file
+#define EXT_SORT_DIR "/tmp"
+
+#define TOPK_HEAP_RATIO 32	// bounded heap while k <= n / ratio
+
+#define RECORD_SORT_N (1 << 20)
+#define PAIR_MAX_PAYLOAD 256
+
 
 Profiler profiler("QuickSort-QuickSelect");
 
@@ -61,7 +107,14 @@ int H_PARENT(int i) {
 	return (i-1)/2;
 }
 
-void max_heapify(int i, int *heap, int n) {
+// exchanges A[i] and A[j] and whatever travels with them (ctx)
+typedef void (*SwapFn)(int *A, int i, int j, void *ctx);
+
+void swap_keys(int *A, int i, int j, void *) {
+	int_swap_count(&A[i], &A[j], NULL);
+}
+
+void max_heapify(int i, int *heap, int n, SwapFn swap = swap_keys, void *ctx = NULL) {
 	int largest = i;
 
 	if (H_LEFT(i) < n && heap[H_LEFT(i)] > heap[i]) // c++
@@ -73,28 +126,28 @@ void max_heapify(int i, int *heap, int n) {
 	countOperations++;
 
 	if (largest != i) {
-		int_swap_count(&heap[i], &heap[largest], NULL); // a += 3
+		swap(heap, i, largest, ctx); // a += 3
 
-		max_heapify(largest, heap, n);
+		max_heapify(largest, heap, n, swap, ctx);
 	}
 }
 
-void build_max_heap_bu(int *heap, int n) {
+void build_max_heap_bu(int *heap, int n, SwapFn swap = swap_keys, void *ctx = NULL) {
 	for (int i = n/2; i >= 0; i--)
-		max_heapify(i, heap, n);
+		max_heapify(i, heap, n, swap, ctx);
 }
 
-void heap_sort(int *A, int n) {
-	build_max_heap_bu(A, n);
+void heap_sort(int *A, int n, SwapFn swap = swap_keys, void *ctx = NULL) {
+	build_max_heap_bu(A, n, swap, ctx);
 
 	for (int i=n-1; i >= 1; i--) {
-		int_swap_count(&A[i], &A[0], NULL);
-		max_heapify(0, A, --n);
+		swap(A, i, 0, ctx);
+		max_heapify(0, A, --n, swap, ctx);
 	}
 }
 
 
-int partition(int* A, int l, int r) {
+int partition_swap(int* A, int l, int r, SwapFn swap, void *ctx) {
 	int x = A[r];	// pivot chosen as last element
 	countOperations++;	// a++
 	int i = l-1;
@@ -102,19 +155,26 @@ int partition(int* A, int l, int r) {
 	for (int j=l; j < r; j++)
 		if (A[j] <= x) {
 			i++;
-			int_swap_count(&A[i], &A[j], NULL);
+			swap(A, i, j, ctx);
 		}
 
 	countOperations++;	// c++
-	int_swap_count(&A[i+1], &A[r], NULL);
+	swap(A, i+1, r, ctx);
 
 	return i+1;
 }
 
-int randomized_partition(int* A, int l, int r) {
-	int i = l + (rand() % (r-l+1));
+int partition(int* A, int l, int r) {
+	return partition_swap(A, l, r, swap_keys, NULL);
+}
+
+// partition() or a drop-in with the same contract, like partition_simd
+typedef int (*Partition)(int* A, int l, int r);
+
+int randomized_partition(int* A, int l, int r, Partition part = partition) {
+	int i = l + rngBounded(r-l+1);
 	int_swap_count(&A[r], &A[i], NULL);
-	return partition(A, l, r);
+	return part(A, l, r);
 }
 
 void quicksort(int* A, int l, int r) {
@@ -126,17 +186,24 @@ void quicksort(int* A, int l, int r) {
 	quicksort(A, m+1, r);
 }
 
-void quicksort_randomized(int* A, int l, int r) {
+void quicksort_randomized(int* A, int l, int r, Partition part = partition) {
 	if (l >= r)
 		return;
 
-	int m = randomized_partition(A, l, r);
-	quicksort_randomized(A, l, m-1);
-	quicksort_randomized(A, m+1, r);
+	int m = randomized_partition(A, l, r, part);
+	quicksort_randomized(A, l, m-1, part);
+	quicksort_randomized(A, m+1, r, part);
+}
+
+// the lab quicksort with the vectorized partition, in the RunSortFn shape;
+// the partition scratch is freed before returning
+void quicksort_simd(int* A, int n) {
+	quicksort_randomized(A, 0, n-1, partition_simd);
+	simd_scratch_release();
 }
 
 int randomized_select(int* A, int l, int r, int i) {
-	if (l == r)
+	if (l >= r)	// i=0 (min) can walk past the left end
 		return A[l];
 
 	int m, k;
@@ -152,11 +219,182 @@ int randomized_select(int* A, int l, int r, int i) {
 		return randomized_select(A, m+1, r, i-k);
 }
 
+typedef struct {
+	int *heap;		// max-heap of the k best so far (complemented for largest)
+	int k, len;
+	bool largest;
+} TopK;
+
+TopK* createTopK(int k, bool largest) {
+	assert(k > 0);
+	TopK *t = (TopK*) malloc(sizeof(TopK));
+	assert(t != NULL);
+
+	t->heap = (int*) malloc(k * sizeof(int));
+	assert(t->heap != NULL);
+	t->k = k;
+	t->len = 0;
+	t->largest = largest;
+
+	return t;
+}
+
+void topkPush(TopK *t, int x) {
+	if (t->largest)
+		x = ~x;
+
+	if (t->len < t->k) {
+		t->heap[t->len++] = x;
+		countOperations++;	// a++
+
+		if (t->len == t->k)
+			build_max_heap_bu(t->heap, t->k);
+		return;
+	}
+
+	countOperations++;	// c++
+	if (x < t->heap[0]) {
+		t->heap[0] = x;
+		countOperations++;	// a++
+		max_heapify(0, t->heap, t->k);
+	}
+}
+
+// writes the kept elements in order (smallest first, or largest first), returns their count
+int topkFinish(TopK *t, int *out) {
+	heap_sort(t->heap, t->len);
+
+	for (int i=0; i < t->len; i++)
+		out[i] = t->largest ? ~t->heap[i] : t->heap[i];
+	countOperations += t->len;
+
+	return t->len;
+}
+
+void freeTopK(TopK *t) {
+	free(t->heap);
+	free(t);
+}
+
+// moves the k smallest elements of A to A[0..k-1], in sorted order
+void topk_select(int *A, int n, int k) {
+	int l = 0, r = n-1;
+
+	while (l < r) {
+		int m = randomized_partition(A, l, r);
+
+		if (m == k-1)
+			break;
+		if (m < k-1)
+			l = m+1;
+		else
+			r = m-1;
+	}
+
+	quicksort_randomized(A, 0, k-1);
+}
+
+void complement_array(int *A, int n) {
+	for (int i=0; i < n; i++)
+		A[i] = ~A[i];
+	countOperations += n;
+}
+
+// the k smallest (or largest) elements of A into out, sorted best first; A may be reordered
+void topk(int *A, int n, int k, int *out, bool largest) {
+	assert(k > 0 && k <= n);
+
+	if (k <= n / TOPK_HEAP_RATIO) {
+		TopK *t = createTopK(k, largest);
+		for (int i=0; i < n; i++)
+			topkPush(t, A[i]);
+		topkFinish(t, out);
+		freeTopK(t);
+		return;
+	}
+
+	if (largest)
+		complement_array(A, n);
+
+	topk_select(A, n, k);
+
+	for (int i=0; i < k; i++)
+		out[i] = largest ? ~A[i] : A[i];
+	countOperations += k;
+
+	if (largest)
+		complement_array(A, n);
+}
+
+typedef struct {
+	int *keys;
+	char *payload;
+	int size;		// bytes per payload element
+} PairArrays;
+
+// SwapFn for a PairArrays ctx: the payloads follow the keys
+void pair_swap(int *keys, int i, int j, void *ctx) {
+	PairArrays *P = (PairArrays*) ctx;
+
+	if (i == j)
+		return;
+
+	int_swap_count(&keys[i], &keys[j], NULL);	// a += 3
+
+	if (P->size == sizeof(unsigned int)) {
+		unsigned int *v = (unsigned int*) P->payload;
+		unsigned int tmp = v[i];
+		v[i] = v[j];
+		v[j] = tmp;
+	} else {
+		char tmp[PAIR_MAX_PAYLOAD];
+		memcpy(tmp, P->payload + (size_t) i * P->size, P->size);
+		memcpy(P->payload + (size_t) i * P->size, P->payload + (size_t) j * P->size, P->size);
+		memcpy(P->payload + (size_t) j * P->size, tmp, P->size);
+	}
+}
+
+void pair_quicksort_randomized(PairArrays *P, int l, int r) {
+	if (l >= r)
+		return;
+
+	pair_swap(P->keys, r, l + rngBounded(r-l+1), P);
+	int m = partition_swap(P->keys, l, r, pair_swap, P);
+	pair_quicksort_randomized(P, l, m-1);
+	pair_quicksort_randomized(P, m+1, r);
+}
+
+// sorts keys and moves payload (n elements of size bytes) along with them
+void pair_sort(int *keys, void *payload, int size, int n, bool useHeap) {
+	assert(size > 0 && size <= PAIR_MAX_PAYLOAD);
+	PairArrays P = { keys, (char*) payload, size };
+
+	if (useHeap)
+		heap_sort(keys, n, pair_swap, &P);
+	else
+		pair_quicksort_randomized(&P, 0, n-1);
+}
+
+// idx becomes the permutation that sorts keys; keys is left untouched
+void argsort(const int *keys, unsigned int *idx, int n, bool useHeap) {
+	int *tmp = (int*) malloc(n * sizeof(int));
+	assert(tmp != NULL);
+
+	for (int i=0; i < n; i++) {
+		tmp[i] = keys[i];
+		idx[i] = i;
+	}
+
+	pair_sort(tmp, idx, sizeof(unsigned int), n, useHeap);
+	free(tmp);
+}
+
 void demo() {
 	int arr[] = {41, 80, 82, 4, 34, 14, 58, 22, 23, 56, 3, 9};
 	int n = sizeof(arr)/sizeof(int);
-	int backup[n];
+	int backup[n], original[n];
 	CopyArray(backup, arr, n);
+	CopyArray(original, arr, n);
 
 	printf("Original array: ");
 	for (int i=0; i < n; i++)
@@ -193,18 +431,86 @@ void demo() {
 	for (int i=0; i < n; i++)
 		printf("%d ", arr[i]);
 
+	CopyArray(arr, backup, n);
+	// 4. testing radix sort
+	radix_sort_lsd(arr, n);
+	assert(IsSorted(arr, n));
+
+	printf("\nRadix sorted: ");
+	for (int i=0; i < n; i++)
+		printf("%d ", arr[i]);
+
+	CopyArray(arr, backup, n);
+	// 5. testing vectorized quicksort
+	quicksort_simd(arr, n);
+	assert(IsSorted(arr, n));
+
+	printf("\nSIMD quicksorted (level %d): ", cpuSimdLevel());
+	for (int i=0; i < n; i++)
+		printf("%d ", arr[i]);
+
+	// 6. testing top-k, both paths and both directions
+	int top[n];
+	for (int k=1; k <= n; k++) {
+		CopyArray(r, backup, n);
+		topk(r, n, k, top, false);
+		for (int i=0; i < k; i++)
+			assert(top[i] == arr[i]);
+
+		CopyArray(r, backup, n);
+		topk(r, n, k, top, true);
+		for (int i=0; i < k; i++)
+			assert(top[i] == arr[n-1-i]);
+
+		TopK *t = createTopK(k, true);
+		for (int i=0; i < n; i++)
+			topkPush(t, backup[i]);
+		int kept = topkFinish(t, top);
+		assert(kept == k);
+		(void) kept;
+		for (int i=0; i < k; i++)
+			assert(top[i] == arr[n-1-i]);
+		freeTopK(t);
+	}
+
+	printf("\nTop 3 smallest: %d %d %d, top 3 largest: ", arr[0], arr[1], arr[2]);
+	CopyArray(r, backup, n);
+	topk(r, n, 3, top, true);
+	printf("%d %d %d", top[0], top[1], top[2]);
+
+	// 7. testing argsort and pair sort
+	unsigned int idx[n];
+	argsort(original, idx, n, false);
+	for (int i=0; i < n; i++)
+		assert(original[idx[i]] == arr[i]);
+	argsort(original, idx, n, true);
+	for (int i=0; i < n; i++)
+		assert(original[idx[i]] == arr[i]);
+
+	printf("\nArgsort: ");
+	for (int i=0; i < n; i++)
+		printf("%u ", idx[i]);
+
+	CopyArray(r, original, n);
+	for (int i=0; i < n; i++)
+		top[i] = -original[i];	// payload that must follow its key
+	pair_sort(r, top, sizeof(int), n, true);
+	assert(IsSorted(r, n));
+	for (int i=0; i < n; i++)
+		assert(top[i] == -r[i]);
+
 	printf("\n");
 
 }
 
 void average_case() {
-	char *series[] = { "quickSort_average", "heapSort_average"};
+	char *series[] = { "quickSort_average", "heapSort_average", "radixSort_average"};
 
 	for (int rep=0; rep < AVG_CASE_TRIALS; rep++) {
 		for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 			// initialize working and backup array
 			int arr[dim];
-			FillRandomArray(arr, dim,
+			rngFillArray(arr, dim,
 				RANGE_MIN, RANGE_MAX, false, UNSORTED);
 
 			int backup[dim];
@@ -223,13 +529,20 @@ void average_case() {
 			heap_sort(arr, dim);
 			assert(IsSorted(arr, dim));
 			profiler.countOperation(series[1], dim, countOperations);
+
+			CopyArray(arr, backup, dim);
+			// 4. test radix sort
+			countOperations = 0;
+			radix_sort_lsd(arr, dim);
+			assert(IsSorted(arr, dim));
+			profiler.countOperation(series[2], dim, countOperations);
 		}
 	}
 
-	for (int i=0; i < 2; i++)
+	for (int i=0; i < 3; i++)
 		profiler.divideOperation(series[i], AVG_CASE_TRIALS, DIM_MIN, DIM_MAX, STEP_SIZE);
 
-	profiler.createGroup("Average_total", series[0], series[1]);
+	profiler.createGroup("Average_total", series[0], series[1], series[2]);
 
 }
 
@@ -239,7 +552,7 @@ void worst_case() {
 	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 		// initialize working and backup array
 		int arr[dim];
-		FillRandomArray(arr, dim,
+		rngFillArray(arr, dim,
 			RANGE_MIN, RANGE_MAX, false, DESCENDING);
 
 		countOperations = 0;
@@ -255,11 +568,11 @@ void best_case() {
 
 	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
 		// initialize working and backup array
-		int arr_tmp[dim], *arr;
-		FillRandomArray(arr_tmp, dim,
+		int arr_tmp[dim], arr[dim];
+		rngFillArray(arr_tmp, dim,
 			RANGE_MIN, RANGE_MAX, false, ASCENDING);
 
-		arr = sortedArrayToPO(arr_tmp, dim);
+		genBestCasePO(arr_tmp, arr, dim);
 
 		countOperations = 0;
 		quicksort(arr, 0, dim-1);
@@ -269,14 +582,281 @@ void best_case() {
 
 }
 
+void generator_cases() {
+	char *series[] = { "quickSort_organPipe", "heapSort_organPipe",
+		"quickSort_sawtooth", "heapSort_sawtooth",
+		"quickSort_fewUnique", "heapSort_fewUnique",
+		"quickSort_zipf", "heapSort_zipf",
+		"quickSort_adversary" };
+	char *groups[] = { "organPipe", "sawtooth", "fewUnique", "zipf" };
+
+	for (int dim=DIM_MIN; dim <= DIM_MAX; dim += STEP_SIZE) {
+		int arr[dim], backup[dim];
+
+		for (int g=0; g < 4; g++) {
+			switch (g) {
+				case 0: genOrganPipe(backup, dim, RANGE_MIN, RANGE_MAX); break;
+				case 1: genSawtooth(backup, dim, 100, RANGE_MIN, RANGE_MAX); break;
+				case 2: genFewUnique(backup, dim, 10, RANGE_MIN, RANGE_MAX); break;
+				case 3: genZipf(backup, dim, RANGE_MIN, RANGE_MAX, 1.0); break;
+			}
+
+			CopyArray(arr, backup, dim);
+			countOperations = 0;
+			quicksort_randomized(arr, 0, dim-1);
+			assert(IsSorted(arr, dim));
+			profiler.countOperation(series[2*g], dim, countOperations);
+
+			CopyArray(arr, backup, dim);
+			countOperations = 0;
+			heap_sort(arr, dim);
+			assert(IsSorted(arr, dim));
+			profiler.countOperation(series[2*g + 1], dim, countOperations);
+
+			CopyArray(arr, backup, dim);
+			quicksort_simd(arr, dim);
+			assert(IsSorted(arr, dim));
+		}
+
+		// the adversary and the sort must see the same pivot draws
+		uint64_t seed = rngNext64();
+		rngSeedThread(seed, 0);
+		genAntiQuicksort(arr, backup, dim, genSortRandomPivot, RANGE_MIN);
+
+		CopyArray(backup, arr, dim);
+		rngSeedThread(seed, 0);
+		countOperations = 0;
+		quicksort_randomized(arr, 0, dim-1);
+		assert(IsSorted(arr, dim));
+		profiler.countOperation(series[8], dim, countOperations);
+
+		quicksort_simd(backup, dim);
+		assert(IsSorted(backup, dim));
+	}
+
+	for (int g=0; g < 4; g++)
+		profiler.createGroup(groups[g], series[2*g], series[2*g + 1]);
+	profiler.createGroup("adversary vs average", "quickSort_adversary", "quickSort_average");
+}
+
+// n fixed, k varies: both top-k paths against sorting everything
+void topk_cases() {
+	char *series[] = { "topK_heap", "topK_select", "topK_auto", "fullSort" };
+	int n = DIM_MAX;
+	int *arr = (int*) malloc(n * sizeof(int));
+	int *backup = (int*) malloc(n * sizeof(int));
+	int *out = (int*) malloc(n * sizeof(int));
+
+	for (int rep=0; rep < AVG_CASE_TRIALS; rep++) {
+		for (int k=DIM_MIN; k <= n; k += STEP_SIZE) {
+			rngFillArray(backup, n, RANGE_MIN, RANGE_MAX, false, UNSORTED);
+
+			CopyArray(arr, backup, n);
+			countOperations = 0;
+			TopK *t = createTopK(k, false);
+			for (int i=0; i < n; i++)
+				topkPush(t, arr[i]);
+			topkFinish(t, out);
+			freeTopK(t);
+			assert(IsSorted(out, k));
+			profiler.countOperation(series[0], k, countOperations);
+
+			countOperations = 0;
+			topk_select(arr, n, k);
+			assert(IsSorted(arr, k));
+			profiler.countOperation(series[1], k, countOperations);
+
+			CopyArray(arr, backup, n);
+			countOperations = 0;
+			topk(arr, n, k, out, false);
+			profiler.countOperation(series[2], k, countOperations);
+
+			CopyArray(arr, backup, n);
+			countOperations = 0;
+			quicksort_randomized(arr, 0, n-1);
+			profiler.countOperation(series[3], k, countOperations);
+
+			for (int i=0; i < k; i++)
+				assert(out[i] == arr[i]);
+		}
+	}
+
+	for (int i=0; i < 4; i++)
+		profiler.divideOperation(series[i], AVG_CASE_TRIALS, DIM_MIN, n, STEP_SIZE);
+	profiler.createGroup("TopK_n_10000", series[0], series[1], series[2], series[3]);
+
+	free(arr);
+	free(backup);
+	free(out);
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+// sort n wide records by their first int: moving them vs argsort + one gather
+void record_sort_benchmark() {
+	int sizes[] = { 64, 256 };
+	int n = RECORD_SORT_N;
+	printf("\nsorting %d records by key (ms)\n", n);
+	printf("%8s | %12s | %12s | %12s | %12s\n", "bytes", "pair_quick", "pair_heap",
+		"argsort_qs", "argsort_heap");
+
+	for (int s=0; s < 2; s++) {
+		int size = sizes[s];
+		char *records = (char*) malloc((size_t) n * size);
+		char *work = (char*) malloc((size_t) n * size);
+		char *sorted = (char*) malloc((size_t) n * size);
+		int *keys = (int*) malloc(n * sizeof(int));
+		unsigned int *idx = (unsigned int*) malloc(n * sizeof(unsigned int));
+		double ms[4];
+
+		for (int i=0; i < n; i++) {
+			for (int b=0; b < size; b++)
+				records[(size_t) i * size + b] = (char) i;
+			*(int*) (records + (size_t) i * size) = rngRange(RANGE_MIN, RANGE_MAX);
+		}
+
+		for (int alg=0; alg < 4; alg++) {
+			auto start = std::chrono::steady_clock::now();
+
+			if (alg < 2) {
+				// key array + the whole record as payload
+				memcpy(work, records, (size_t) n * size);
+				for (int i=0; i < n; i++)
+					keys[i] = *(int*) (work + (size_t) i * size);
+				pair_sort(keys, work, size, n, alg == 1);
+				memcpy(sorted, work, (size_t) n * size);
+			} else {
+				for (int i=0; i < n; i++)
+					keys[i] = *(int*) (records + (size_t) i * size);
+				argsort(keys, idx, n, alg == 3);
+				for (int i=0; i < n; i++)
+					memcpy(sorted + (size_t) i * size, records + (size_t) idx[i] * size, size);
+			}
+
+			ms[alg] = ms_since(start);
+
+			for (int i=1; i < n; i++)
+				assert(*(int*) (sorted + (size_t) (i-1) * size) <= *(int*) (sorted + (size_t) i * size));
+		}
+
+		printf("%8d | %12.1f | %12.1f | %12.1f | %12.1f\n", size, ms[0], ms[1], ms[2], ms[3]);
+
+		free(records);
+		free(work);
+		free(sorted);
+		free(keys);
+		free(idx);
+	}
+}
+
+// wall time in ms, the arrays are too large for the operation counter
+void sort_timing() {
+	printf("\n%10s | %10s | %10s | %10s | %10s\n",
+		"n", "quicksort", "qs_simd", "radix_lsd", "radix_msd");
+
+	for (int n = 1 << 20; n <= 1 << 24; n <<= 2) {
+		int *arr = (int*) malloc(n * sizeof(int));
+		int *backup = (int*) malloc(n * sizeof(int));
+		double ms[4];
+		rngFillArray(backup, n, RANGE_MIN, RANGE_MAX, false, UNSORTED);
+
+		for (int alg=0; alg < 4; alg++) {
+			CopyArray(arr, backup, n);
+			auto start = std::chrono::steady_clock::now();
+
+			switch (alg) {
+				case 0: quicksort_randomized(arr, 0, n-1); break;
+				case 1: quicksort_simd(arr, n); break;
+				case 2: radix_sort_lsd(arr, n); break;
+				case 3: radix_sort_msd_parallel(arr, n); break;
+			}
+
+			ms[alg] = ms_since(start);
+			assert(IsSorted(arr, n));
+		}
+
+		printf("%10d | %10.1f | %10.1f | %10.1f | %10.1f\n", n, ms[0], ms[1], ms[2], ms[3]);
+		free(arr);
+		free(backup);
+	}
+}
+
+void external_sort_benchmark() {
+	char inPath[256], outPath[256];
+	sprintf(inPath, "%s/extsort-input.bin", EXT_SORT_DIR);
+	sprintf(outPath, "%s/extsort-output.bin", EXT_SORT_DIR);
+	int64_t budgets[] = { 256 << 20, 64 << 20, 16 << 20, 1 << 20 };
+	int64_t inSum = 0;
+
+	// 1. generate the input file
+	int fd = open(inPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	assert(fd >= 0);
+	BlockWriter w;
+	writerOpen(&w, fd, 0, 1 << 20);
+	for (int i=0; i < EXT_SORT_INTS; i++) {
+		int v = (int) rngNext32();
+		inSum += v;
+		writerPut(&w, v);
+	}
+	int64_t written = writerClose(&w);
+	assert(written == (int64_t) EXT_SORT_INTS * sizeof(int));
+	(void) written;
+	close(fd);
+
+	printf("\nexternal sort of %d ints (%d MB)\n", EXT_SORT_INTS, (int) (EXT_SORT_INTS * sizeof(int) >> 20));
+	printf("%10s | %6s | %6s | %10s | %8s\n", "budget MB", "runs", "passes", "ms", "MB/s");
+
+	for (int b=0; b < 4; b++) {
+		ExtSortConfig cfg = { budgets[b], EXT_SORT_DIR, quicksort_simd, 0, 0 };
+
+		auto start = std::chrono::steady_clock::now();
+		bool ok = externalSort(inPath, outPath, &cfg);
+		double ms = ms_since(start);
+		assert(ok);
+
+		// 2. verify: sorted, same count and same sum
+		BlockReader r;
+		int64_t count = 0, outSum = 0;
+		int prev = INT_MIN, v;
+		fd = open(outPath, O_RDONLY);
+		assert(fd >= 0);
+		readerOpen(&r, fd, 0, (int64_t) EXT_SORT_INTS * sizeof(int), 1 << 20);
+		while (readerNext(&r, &v)) {
+			assert(prev <= v);
+			prev = v;
+			outSum += v;
+			count++;
+		}
+		ok = readerClose(&r);
+		close(fd);
+		assert(ok && count == EXT_SORT_INTS && outSum == inSum);
+		(void) ok;
+		(void) prev;
+
+		printf("%10d | %6d | %6d | %10.1f | %8.1f\n", (int) (budgets[b] >> 20),
+			(int) cfg.runs, cfg.passes, ms,
+			EXT_SORT_INTS * sizeof(int) / 1048576.0 / (ms / 1000));
+	}
+
+	unlink(inPath);
+	unlink(outPath);
+}
 
 int main() {
-	srand(time(NULL));
+	rngSeed(RNG_SEED);
 
 	demo();
 	average_case();
 	worst_case();
 	best_case();
+	generator_cases();
+	topk_cases();
+	sort_timing();
+	record_sort_benchmark();
+	external_sort_benchmark();
 
 	profiler.createGroup("average vs best", "quickSort_average", "quickSort_best");
 	profiler.showReport();
@@ -0,0 +1,219 @@
+/*	Radix sorts for 32 bit int keys.
+
+	- radix_sort_lsd: least significant digit first, 11 bit digits
+	  (3 passes for 32 bits), the histograms of all digits are built in
+	  one pass over the input, a digit where every key falls in the same
+	  bucket is skipped
+	- radix_sort_msd_parallel: one 8 bit MSD scatter done in parallel,
+	  then every bucket is finished with the LSD sort on the bits below
+	  it, buckets are handed out to threads from a shared counter; the
+	  digit is taken just below the top bits that are the same in every
+	  key, so a small key range (1..RANGE_MAX) still spreads over all
+	  the buckets instead of landing in one
+	- signed keys are handled by flipping the sign bit
+
+	countOperations (lab file) gets one per histogram read and one per
+	key moved; the parallel version does not count
+	compile with -pthread
+*/
+
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#define RADIX_BITS 11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MSD_BITS 8
+#define RADIX_MSD_BUCKETS (1 << RADIX_MSD_BITS)
+#define RADIX_SMALL 64
+
+extern unsigned int countOperations;
+
+static inline uint32_t radixKey(int x) {
+	return (uint32_t) x ^ 0x80000000u;
+}
+
+static void radix_insertion_sort(int *A, int n) {
+	for (int i=1; i < n; i++) {
+		int x = A[i], j = i-1;
+		while (j >= 0 && A[j] > x) {
+			A[j+1] = A[j];
+			j--;
+		}
+		A[j+1] = x;
+	}
+}
+
+/*	sorts src[0..n) on the low `bits` bits of the key, buf is scratch of n;
+	returns whichever of src/buf holds the result
+*/
+static int* radix_lsd_bits(int *src, int *buf, int n, int bits, bool count) {
+	int digits = (bits + RADIX_BITS - 1) / RADIX_BITS;
+	static thread_local unsigned int hist[(32 + RADIX_BITS - 1) / RADIX_BITS][RADIX_BUCKETS];
+	memset(hist, 0, digits * sizeof(hist[0]));
+
+	// one pass for all histograms
+	for (int i=0; i < n; i++) {
+		uint32_t k = radixKey(src[i]);
+		for (int d=0; d < digits; d++)
+			hist[d][(k >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+	}
+	if (count)
+		countOperations += n;
+
+	for (int d=0; d < digits; d++) {
+		int shift = d * RADIX_BITS;
+		unsigned int *h = hist[d];
+
+		// trivial digit, every key in one bucket
+		if (h[(radixKey(src[0]) >> shift) & (RADIX_BUCKETS - 1)] == (unsigned int) n)
+			continue;
+
+		unsigned int sum = 0;
+		for (int b=0; b < RADIX_BUCKETS; b++) {
+			unsigned int c = h[b];
+			h[b] = sum;
+			sum += c;
+		}
+
+		for (int i=0; i < n; i++)
+			buf[h[(radixKey(src[i]) >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+		if (count)
+			countOperations += n;
+
+		int *tmp = src;
+		src = buf;
+		buf = tmp;
+	}
+
+	return src;
+}
+
+void radix_sort_lsd(int *A, int n) {
+	if (n < 2)
+		return;
+
+	int *buf = (int*) malloc(n * sizeof(int));
+	assert(buf != NULL);
+
+	int *out = radix_lsd_bits(A, buf, n, 32, true);
+	if (out != A) {
+		memcpy(A, out, n * sizeof(int));
+		countOperations += n;
+	}
+
+	free(buf);
+}
+
+void radix_sort_msd_parallel(int *A, int n, int threads = 0) {
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads <= 1 || n < (1 << 16)) {
+		radix_sort_lsd(A, n);
+		return;
+	}
+
+	std::vector<uint32_t> diff(threads, 0);
+	std::vector<std::thread> pool;
+	int chunk = (n + threads - 1) / threads;
+	uint32_t k0 = radixKey(A[0]);
+
+	// 0. bits where some key differs from A[0], the ones above are common
+	for (int t=0; t < threads; t++)
+		pool.push_back(std::thread([=, &diff] {
+			uint32_t d = 0;
+			int end = std::min(n, (t+1) * chunk);
+			for (int i=t * chunk; i < end; i++)
+				d |= radixKey(A[i]) ^ k0;
+			diff[t] = d;
+		}));
+	for (auto &th : pool)
+		th.join();
+	pool.clear();
+
+	uint32_t d = 0;
+	for (int t=0; t < threads; t++)
+		d |= diff[t];
+	if (d == 0)		// every key is equal
+		return;
+
+	// the digit is the RADIX_MSD_BITS ending at the highest differing bit
+	int top = 32 - __builtin_clz(d);
+	const int shift = top > RADIX_MSD_BITS ? top - RADIX_MSD_BITS : 0;
+	int *buf = (int*) malloc(n * sizeof(int));
+	assert(buf != NULL);
+
+	std::vector<unsigned int> hist(threads * RADIX_MSD_BUCKETS, 0);
+
+	// 1. per thread histograms of the top digit
+	for (int t=0; t < threads; t++)
+		pool.push_back(std::thread([=, &hist] {
+			unsigned int *h = &hist[t * RADIX_MSD_BUCKETS];
+			int end = std::min(n, (t+1) * chunk);
+			for (int i=t * chunk; i < end; i++)
+				h[(radixKey(A[i]) >> shift) & (RADIX_MSD_BUCKETS - 1)]++;
+		}));
+	for (auto &th : pool)
+		th.join();
+	pool.clear();
+
+	// 2. exclusive prefix sums, bucket major so every thread owns a slice
+	unsigned int bucketStart[RADIX_MSD_BUCKETS + 1];
+	unsigned int sum = 0;
+	for (int b=0; b < RADIX_MSD_BUCKETS; b++) {
+		bucketStart[b] = sum;
+		for (int t=0; t < threads; t++) {
+			unsigned int c = hist[t * RADIX_MSD_BUCKETS + b];
+			hist[t * RADIX_MSD_BUCKETS + b] = sum;
+			sum += c;
+		}
+	}
+	bucketStart[RADIX_MSD_BUCKETS] = sum;
+
+	// 3. parallel scatter into buf
+	for (int t=0; t < threads; t++)
+		pool.push_back(std::thread([=, &hist] {
+			unsigned int *h = &hist[t * RADIX_MSD_BUCKETS];
+			int end = std::min(n, (t+1) * chunk);
+			for (int i=t * chunk; i < end; i++)
+				buf[h[(radixKey(A[i]) >> shift) & (RADIX_MSD_BUCKETS - 1)]++] = A[i];
+		}));
+	for (auto &th : pool)
+		th.join();
+	pool.clear();
+
+	// 4. finish buckets independently, result goes back into A
+	std::atomic<int> next(0);
+	for (int t=0; t < threads; t++)
+		pool.push_back(std::thread([&, shift] {
+			int b;
+			while ((b = next++) < RADIX_MSD_BUCKETS) {
+				int lo = bucketStart[b], len = bucketStart[b+1] - lo;
+				if (len == 0)
+					continue;
+
+				if (len <= RADIX_SMALL) {
+					radix_insertion_sort(buf + lo, len);
+					memcpy(A + lo, buf + lo, len * sizeof(int));
+					continue;
+				}
+
+				int *out = radix_lsd_bits(buf + lo, A + lo, len, shift, false);
+				if (out != A + lo)
+					memcpy(A + lo, out, len * sizeof(int));
+			}
+		}));
+	for (auto &th : pool)
+		th.join();
+
+	free(buf);
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*	Vectorized partition for quicksort.
+
+	- partition_simd(A, l, r) has the contract of partition() in the lab
+	  file, so quicksort_randomized takes it as a drop-in: the pivot is
+	  A[r], keys < pivot go left, keys > pivot go right
+	- keys equal to the pivot are split between the sides by lane parity,
+	  so a run of equal keys is halved instead of all landing on the left:
+	  few-unique inputs stay O(n log n) instead of turning quadratic
+	- each step compares a whole vector against the pivot, the left lanes
+	  ("<", and "==" in even lanes) are compressed and stored back into A
+	  at the left cursor (which never passes the read cursor), the right
+	  lanes (">", and "==" in odd lanes) are compressed into the scratch
+	  buffer and copied back after the loop
+	- AVX-512 uses the native compress store, AVX2 a 256 entry
+	  permutation table indexed by the comparison mask
+	- the version is picked once at runtime (common/cpu.h), anything
+	  else falls back to the same scheme in scalar code
+	- the scratch buffer is kept per thread and grows to the largest
+	  partition seen; simd_scratch_release() frees it, quicksort_simd
+	  calls it when a sort is done so nothing stays allocated between
+	  sorts
+
+	countOperations: one comparison and one write per key, plus the
+	copy back of the right side and the pivot swap
+*/
+
+#ifndef SIMD_PARTITION_H
+#define SIMD_PARTITION_H
+
+#include "../common/cpu.h"
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+extern unsigned int countOperations;
+
+typedef int (*PartitionKernel)(int *A, int l, int r, int *tmp);
+
+/*	partitions A[j..r-1] around x, left keys are written from A[i] on
+	(i <= j), right keys are appended to tmp; returns the new left cursor
+*/
+static int partition_block_scalar(int *A, int i, int j, int r, int x, int *tmp, int *g) {
+	for (; j < r; j++) {
+		int v = A[j];
+		int gt = (v > x) | ((v == x) & j);	// equal keys at odd j go right
+		// branchless: write to both sides, advance only one cursor
+		A[i] = v;
+		tmp[*g] = v;
+		i += !gt;
+		*g += gt;
+	}
+
+	return i;
+}
+
+static int finish_partition(int *A, int l, int r, int i, int *tmp, int g) {
+	memcpy(A + i, tmp, g * sizeof(int));
+
+	int pivot = A[r];
+	A[r] = A[i];
+	A[i] = pivot;
+
+	countOperations += 2 * (r - l) + g + 3;
+	return i;
+}
+
+int partition_scalar(int *A, int l, int r, int *tmp) {
+	int g = 0;
+	int i = partition_block_scalar(A, l, l, r, A[r], tmp, &g);
+	return finish_partition(A, l, r, i, tmp, g);
+}
+
+#ifdef CPU_X86
+
+// perm[m] moves the lanes set in m to the front, in order
+static uint32_t simdPerm8[256][8];
+
+static void build_perm_table() {
+	for (int m=0; m < 256; m++) {
+		int k = 0;
+		for (int lane=0; lane < 8; lane++)
+			if (m & (1 << lane))
+				simdPerm8[m][k++] = lane;
+		while (k < 8)
+			simdPerm8[m][k++] = 0;
+	}
+}
+
+__attribute__((target("avx2,popcnt")))
+int partition_avx2(int *A, int l, int r, int *tmp) {
+	int x = A[r];
+	__m256i pivot = _mm256_set1_epi32(x);
+	int i = l, g = 0, j = l;
+
+	for (; j + 8 <= r; j += 8) {
+		__m256i v = _mm256_loadu_si256((__m256i*) (A + j));
+		int gt = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivot)));
+		int eq = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, pivot)));
+		gt |= eq & 0xaa;	// equal keys in odd lanes go right
+		int le = ~gt & 0xff;
+
+		__m256i left = _mm256_permutevar8x32_epi32(v,
+			_mm256_loadu_si256((__m256i*) simdPerm8[le]));
+		__m256i right = _mm256_permutevar8x32_epi32(v,
+			_mm256_loadu_si256((__m256i*) simdPerm8[gt]));
+
+		// full width stores, the lanes past each cursor are overwritten later;
+		// the left store ends below j+8, so it only hits keys already loaded
+		_mm256_storeu_si256((__m256i*) (A + i), left);
+		_mm256_storeu_si256((__m256i*) (tmp + g), right);
+		i += __builtin_popcount(le);
+		g += __builtin_popcount(gt);
+	}
+
+	i = partition_block_scalar(A, i, j, r, x, tmp, &g);
+
+	return finish_partition(A, l, r, i, tmp, g);
+}
+
+__attribute__((target("avx512f,popcnt")))
+int partition_avx512(int *A, int l, int r, int *tmp) {
+	int x = A[r];
+	__m512i pivot = _mm512_set1_epi32(x);
+	int i = l, g = 0, j = l;
+
+	for (; j + 16 <= r; j += 16) {
+		__m512i v = _mm512_loadu_si512(A + j);
+		__mmask16 gt = _mm512_cmpgt_epi32_mask(v, pivot)
+			| (_mm512_cmpeq_epi32_mask(v, pivot) & 0xaaaa);	// equal keys in odd lanes go right
+
+		_mm512_mask_compressstoreu_epi32(A + i, (__mmask16) ~gt, v);
+		_mm512_mask_compressstoreu_epi32(tmp + g, gt, v);
+		int ngt = __builtin_popcount(gt);
+		i += 16 - ngt;
+		g += ngt;
+	}
+
+	i = partition_block_scalar(A, i, j, r, x, tmp, &g);
+
+	return finish_partition(A, l, r, i, tmp, g);
+}
+
+#endif
+
+PartitionKernel select_partition() {
+#ifdef CPU_X86
+	if (cpuSimdLevel() >= SIMD_AVX512)
+		return partition_avx512;
+
+	if (cpuSimdLevel() >= SIMD_AVX2) {
+		build_perm_table();
+		return partition_avx2;
+	}
+#endif
+	return partition_scalar;
+}
+
+static PartitionKernel partition_kernel = select_partition();
+
+static thread_local int *simdScratch = NULL;
+static thread_local int simdScratchLen = 0;
+
+// the right side of r-l keys plus one full vector of overspill
+static int *simd_scratch(int n) {
+	if (n + 16 > simdScratchLen) {
+		simdScratchLen = n + 16;
+		simdScratch = (int*) realloc(simdScratch, simdScratchLen * sizeof(int));
+		assert(simdScratch != NULL);
+	}
+
+	return simdScratch;
+}
+
+// frees this thread's scratch, the next partition_simd allocates it again
+void simd_scratch_release() {
+	free(simdScratch);
+	simdScratch = NULL;
+	simdScratchLen = 0;
+}
+
+int partition_simd(int *A, int l, int r) {
+	return partition_kernel(A, l, r, simd_scratch(r - l));
+}
+
+#endif
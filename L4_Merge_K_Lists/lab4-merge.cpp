@@ -25,14 +25,90 @@
 
 	- the total number of elements is the deciding factor in the running time
 	  of the algorithm
+
+	- mergeKListsLT does the same merge with a loser tree (losertree.h):
+	  one match per level on a single leaf-to-root path, so about log k
+	  comparisons per element instead of the 2*log k comparisons and
+	  swaps of min_heapify; both are counted in first_test/second_test
+
+	- ListNode and List come from a slab pool instead of malloc: freeList
+	  gives a whole list back in O(1) and poolRelease() frees every slab
+	  at once; the merges relink the input nodes into the output, so the
+	  input lists are left empty and nothing is allocated per element
+
+	- mergeKArrays merges sorted (pointer, length) spans straight into
+	  one preallocated buffer with the same loser tree; array_test()
+	  times it against arrayToList + mergeKListsLT for k = 2..1024
+
+	- parallelMergeKArrays splits the output into p equal ranges with
+	  multiway co-ranking: a binary search on the key finds, for a rank r,
+	  how many elements of every span come before it (ties are split in
+	  span order, so the result equals the sequential merge); every
+	  thread then merges its own ranges with its own loser tree,
+	  parallel_test() reports the scaling (compile with -pthread)
+
+	- mergeKFiles merges sorted runs stored on disk: every run is read
+	  through a double-buffered BlockReader (common/blockio.h, the next
+	  block is pread in the background) and selected with the same Heap,
+	  where HeapNode.src names the run; the output goes through a
+	  BlockWriter, so memory stays at 2 * (k + 1) blocks whatever the
+	  size of the runs; file_test() writes k run files and times it
+
+	- MergeIter is the same loser tree merge, pulled one element at a
+	  time: mergeIterNext() returns the winner and replays only its path,
+	  so the first N elements cost O(k + N log k) and the input lists are
+	  only read, not relinked; mergeTopN and mergeUntil stop early,
+	  iter_test() compares their operations with a full merge
+
+	- the Gallop merges check the heap root against the runner-up (the
+	  smaller child of the root) and take the whole run of the winner that
+	  is <= the runner-up before one min_heapify: lists splice the run in
+	  one piece, arrays find its end with an exponential then a binary
+	  search and copy it with memcpy; gallop_test() shows the gain on
+	  skewed sizes and disjoint ranges, and the small overhead on
+	  perfectly interleaved lists where every run has length 1
+
+	- mergeKTree is a balanced tree of two-way merges (simd_merge.h,
+	  bitonic networks in AVX2 / AVX-512 registers): every inner node owns
+	  a buffer of MERGE_TREE_BUF ints that stays in cache, and refills it
+	  from its two children only with the keys that are certainly next
+	  (everything <= the smaller of the two children's last buffered
+	  keys), so the kernels always run over whole chunks; the root writes
+	  straight into out. simd_test() compares it with mergeKLists
+
+	- UList is an unrolled list: every UNode holds up to UNROLLED_VALUES
+	  ints, so one cache miss and one pointer serve 32 values instead of
+	  one (ListNode spends 12 bytes of pointer and padding per int);
+	  mergeKUnrolled reads the inputs node by node with the loser tree,
+	  gives every used up node back to the pool and fills the output
+	  from the same free nodes; unrolled_test() compares memory and
+	  throughput with List
+
+	- mergeReduce merges sorted (key, value) runs with the Heap and,
+	  while the top of the heap still has the key just popped, folds it
+	  in with a Combiner (sum of counts, max, keep first = dedup), so
+	  equal keys from different runs are collapsed before anything is
+	  written: the output only needs room for the distinct keys and no
+	  second pass is needed; reduce_test() compares it with merge +
+	  reduceSorted for several numbers of distinct keys
 */
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
+#include "losertree.h"
+#include "../common/blockio.h"
+#include "simd_merge.h"
 #include <cstdio>
 #include <cstdlib>
 #include <climits>
 #include <cassert>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define AVG_CASE_TRIALS 5
 #define DIM_MIN 100
@@ -43,6 +119,20 @@
 
 #define VERBOSE_DEBUG false
 
+#define POOL_SLAB_BYTES (64 * 1024)
+#define ARRAY_TEST_N (1 << 22)
+#define PARALLEL_TEST_N (1 << 26)	// 1 << 30 for 1B elements, needs 8 GB
+#define FILE_TEST_N (1 << 24)
+#define FILE_TEST_DIR "/tmp"
+#define FILE_BLOCK_INTS (64 * 1024)	// 256 KB per block
+#define GALLOP_TEST_N (1 << 22)
+#define GALLOP_TEST_K 64
+#define MERGE_TREE_BUF (4 * 1024)	// 16 KB per inner node
+#define SIMD_TEST_N (1 << 22)
+#define UNROLLED_VALUES 32
+#define UNROLLED_TEST_N (1 << 22)
+#define REDUCE_TEST_N (1 << 22)
+
 Profiler profiler("Merge_k_lists");
 
 unsigned int countOperations = 0;
@@ -57,9 +147,21 @@ typedef struct {
 	int len;
 } List;
 
+typedef struct UNode {
+	struct UNode *next;
+	int count;
+	int vals[UNROLLED_VALUES];
+} UNode;
+
+typedef struct {
+	UNode *first, *last;
+	int len;
+} UList;
+
 typedef struct HeapNode {
 	int val;
-	ListNode *nextNode;
+	ListNode *node;		// current head of the list, val is its key
+	int src;			// run index when merging files, see mergeKFiles
 } HeapNode;
 
 typedef struct {
@@ -68,34 +170,138 @@ typedef struct {
 	int maxLen;
 } Heap;
 
+typedef struct {
+	const int *data;
+	int len;
+} Span;
+
+typedef struct {
+	int key;
+	int value;
+} KeyValue;
+
+// a run of entries sorted by key
+typedef struct {
+	const KeyValue *data;
+	int len;
+} KVSpan;
+
+// folds value into the accumulated value of an equal key
+typedef int (*Combiner)(int acc, int value);
+
+// a sorted run of ints in bytes [offset, offset + bytes) of fd
+typedef struct {
+	int fd;
+	int64_t offset, bytes;
+} RunFile;
+
+typedef struct PoolSlab {
+	struct PoolSlab *prev;
+	size_t used;
+	char mem[POOL_SLAB_BYTES];
+} PoolSlab;
+
+typedef struct {
+	PoolSlab *slab;			// current slab, older ones through prev
+	ListNode *freeNodes;	// given back nodes, chained through next
+	List *freeLists;		// given back headers, chained through first
+	UNode *freeUNodes;		// given back unrolled nodes, chained through next
+	UList *freeULists;		// given back headers, chained through first
+} NodePool;
+
+NodePool nodePool = { NULL, NULL, NULL, NULL, NULL };
+
+void* poolAlloc(size_t size) {
+	size = (size + 7) & ~(size_t) 7;
+
+	if (nodePool.slab == NULL || nodePool.slab->used + size > POOL_SLAB_BYTES) {
+		PoolSlab *slab = (PoolSlab*) malloc(sizeof(PoolSlab));
+		assert(slab != NULL);
+
+		slab->prev = nodePool.slab;
+		slab->used = 0;
+		nodePool.slab = slab;
+	}
+
+	void *p = nodePool.slab->mem + nodePool.slab->used;
+	nodePool.slab->used += size;
+	return p;
+}
+
+// frees every node and list at once, all of them become invalid
+void poolRelease() {
+	while (nodePool.slab != NULL) {
+		PoolSlab *prev = nodePool.slab->prev;
+		free(nodePool.slab);
+		nodePool.slab = prev;
+	}
+
+	nodePool.freeNodes = NULL;
+	nodePool.freeLists = NULL;
+	nodePool.freeUNodes = NULL;
+	nodePool.freeULists = NULL;
+}
+
+ListNode* newListNode(int val) {
+	ListNode *node = nodePool.freeNodes;
+
+	if (node != NULL)
+		nodePool.freeNodes = node->next;
+	else
+		node = (ListNode*) poolAlloc(sizeof(ListNode));
+
+	node->val = val;
+	node->next = NULL;
+	return node;
+}
+
 List* createList() {
-	return (List*) calloc(1, sizeof(List));
+	List *list = nodePool.freeLists;
+
+	if (list != NULL)
+		nodePool.freeLists = (List*) list->first;
+	else
+		list = (List*) poolAlloc(sizeof(List));
+
+	list->first = list->last = NULL;
+	list->len = 0;
+	return list;
 }
 
-void insertListNode(int val, List* list) {
+// relinks node at the end of list
+void appendListNode(ListNode *node, List *list) {
 	assert(list != NULL);
+	assert(node != NULL);
 
-	ListNode* trav = list->last;
+	node->next = NULL;
+	list->len++;
 
-	while (trav != NULL)
-		trav = trav->next;
+	if (list->last == NULL)
+		list->first = node;
+	else
+		list->last->next = node;
 
-	trav = (ListNode*) malloc(sizeof(ListNode));
-	trav->val = val;
-	trav->next = NULL;
-	list->len++;
+	list->last = node;
+}
+
+// relinks the chain first..last of count nodes at the end of list
+void appendListChain(ListNode *first, ListNode *last, int count, List *list) {
+	assert(list != NULL);
+	assert(first != NULL && last != NULL);
 
-	if (list->first == NULL)
-		list->first = trav;
+	last->next = NULL;
+	list->len += count;
 
 	if (list->last == NULL)
-		list->last = trav;
+		list->first = first;
 	else
-		list->last->next = trav;
-
+		list->last->next = first;
 
-	list->last = trav;
+	list->last = last;
+}
 
+void insertListNode(int val, List* list) {
+	appendListNode(newListNode(val), list);
 }
 
 List* arrayToList(int *arr, int n) {
@@ -107,17 +313,128 @@ List* arrayToList(int *arr, int n) {
 	return out;
 }
 
+// O(1), the whole chain is spliced onto the pool's free list
 void freeList(List *list) {
-	ListNode *head = list->first;
-    ListNode *current = NULL;
+	assert(list != NULL);
+
+	if (list->first != NULL) {
+		list->last->next = nodePool.freeNodes;
+		nodePool.freeNodes = list->first;
+	}
+
+	list->first = (ListNode*) nodePool.freeLists;
+	nodePool.freeLists = list;
+}
+
+// the nodes were relinked into another list
+void detachList(List *list) {
+	list->first = list->last = NULL;
+	list->len = 0;
+}
+
+bool listsEqual(List *a, List *b) {
+	ListNode *p = a->first, *q = b->first;
 
-    while ((current = head) != NULL)
-    {
-        head = head->next;
-        free(current);
-    }
+	while (p != NULL && q != NULL && p->val == q->val) {
+		p = p->next;
+		q = q->next;
+	}
+
+	return p == NULL && q == NULL;
+}
+
+UList* createUList() {
+	UList *list = nodePool.freeULists;
+
+	if (list != NULL)
+		nodePool.freeULists = (UList*) list->first;
+	else
+		list = (UList*) poolAlloc(sizeof(UList));
+
+	list->first = list->last = NULL;
+	list->len = 0;
+	return list;
+}
+
+UNode* newUNode() {
+	UNode *node = nodePool.freeUNodes;
+
+	if (node != NULL)
+		nodePool.freeUNodes = node->next;
+	else
+		node = (UNode*) poolAlloc(sizeof(UNode));
+
+	node->next = NULL;
+	node->count = 0;
+	return node;
+}
+
+void releaseUNode(UNode *node) {
+	node->next = nodePool.freeUNodes;
+	nodePool.freeUNodes = node;
+}
 
-	free(list);
+void uListAppend(int val, UList *list) {
+	assert(list != NULL);
+
+	if (list->last == NULL || list->last->count == UNROLLED_VALUES) {
+		UNode *node = newUNode();
+
+		if (list->last == NULL)
+			list->first = node;
+		else
+			list->last->next = node;
+		list->last = node;
+	}
+
+	list->last->vals[list->last->count++] = val;
+	list->len++;
+}
+
+UList* arrayToUList(int *arr, int n) {
+	UList *out = createUList();
+
+	for (int i=0; i < n; i++)
+		uListAppend(arr[i], out);
+
+	return out;
+}
+
+// O(1), like freeList
+void freeUList(UList *list) {
+	assert(list != NULL);
+
+	if (list->first != NULL) {
+		list->last->next = nodePool.freeUNodes;
+		nodePool.freeUNodes = list->first;
+	}
+
+	list->first = (UNode*) nodePool.freeULists;
+	nodePool.freeULists = list;
+}
+
+// position in a UList, for reading it value by value
+typedef struct {
+	UNode *node;
+	int i;
+} UIter;
+
+UIter uListBegin(UList *list) {
+	UIter it = { list->first, 0 };
+	return it;
+}
+
+static inline bool uIterNext(UIter *it, int *val) {
+	if (it->node == NULL)
+		return false;
+
+	*val = it->node->vals[it->i++];
+	if (it->i == it->node->count) {
+		it->node = it->node->next;
+		it->i = 0;
+	}
+
+	return true;
 }
 
 void printList(List *list) {
@@ -208,6 +525,8 @@ Heap* createHeap(int maxLength) {
 	h->len = 0;
 	h->maxLen = maxLength;
 	h->nodes = (HeapNode*) calloc(maxLength, sizeof(HeapNode));
+
+	return h;
 }
 
 void insertHeapNode(ListNode* p, Heap* heap) {
@@ -222,7 +541,23 @@ void insertHeapNode(ListNode* p, Heap* heap) {
 
 	heap->len++;
 	heap->nodes[heap->len-1].val = p->val;		// A++
-	heap->nodes[heap->len-1].nextNode = p->next;
+	heap->nodes[heap->len-1].node = p;
+
+	countOperations++;
+}
+
+void insertHeapSource(int val, int src, Heap* heap) {
+	assert(heap != NULL);
+
+	if (heap->len >= heap->maxLen) {
+		printf("\nHEAP OVERFLOW\n");
+		return;
+	}
+
+	heap->len++;
+	heap->nodes[heap->len-1].val = val;		// A++
+	heap->nodes[heap->len-1].node = NULL;
+	heap->nodes[heap->len-1].src = src;
 
 	countOperations++;
 }
@@ -233,7 +568,7 @@ bool hasNext(int i, Heap* heap) {
 	assert(heap != NULL);
 	assert(heap->nodes != NULL);
 
-	if (heap->nodes[i].nextNode == NULL)
+	if (heap->nodes[i].node->next == NULL)
 		return false;
 
 	return true;
@@ -243,8 +578,8 @@ void advanceHeapNode(int i, Heap* heap) {
 	assert(heap != NULL);
 	assert(heap->nodes != NULL);
 
-	heap->nodes[i].val = heap->nodes[i].nextNode->val;
-	heap->nodes[i].nextNode = heap->nodes[i].nextNode->next;
+	heap->nodes[i].node = heap->nodes[i].node->next;
+	heap->nodes[i].val = heap->nodes[i].node->val;
 }
 
 void removeTopMinHeap(Heap* heap) {
@@ -270,13 +605,15 @@ void freeHeap(Heap* heap) {
 	free(heap);
 }
 
+// consumes the input lists: their nodes are relinked into the result
 List* mergeKLists(List** lists, int k) {
 	int totalSize = 0;
 	Heap *minHeap = createHeap(k);
 
 	for (int i=0; i < k; i++) {
 		totalSize += lists[i]->len;
-		insertHeapNode(lists[i]->first, minHeap);
+		if (lists[i]->first != NULL)
+			insertHeapNode(lists[i]->first, minHeap);
 	}
 
 	buildMinHeapBU(minHeap);
@@ -284,7 +621,7 @@ List* mergeKLists(List** lists, int k) {
 	List* out = createList();
 
 	while (minHeap->len > 0) {
-		insertListNode(getHeapVal(0, minHeap), out);
+		ListNode *taken = minHeap->nodes[0].node;
 
 		if (hasNext(0, minHeap)) {
 			advanceHeapNode(0, minHeap);
@@ -293,19 +630,653 @@ List* mergeKLists(List** lists, int k) {
 			removeTopMinHeap(minHeap);
 		}
 
+		appendListNode(taken, out);
 	}
 
 	if (VERBOSE_DEBUG)
 		printf("Heap size after merging: %d\n", minHeap->len);
 
+	for (int i=0; i < k; i++)
+		detachList(lists[i]);
+
+	freeHeap(minHeap);
+	return out;
+}
+
+// consumes the input lists, like mergeKLists
+List* mergeKListsLT(List** lists, int k) {
+	LoserTree *lt = ltCreate(k);
+	ListNode **cursor = (ListNode**) malloc(k * sizeof(ListNode*));
+	assert(cursor != NULL);
+
+	for (int i=0; i < k; i++) {
+		cursor[i] = lists[i]->first;
+		lt->done[i] = (cursor[i] == NULL);
+		if (cursor[i] != NULL)
+			lt->keys[i] = cursor[i]->val;
+	}
+
+	ltInit(lt);
+
+	List* out = createList();
+
+	while (!ltEmpty(lt)) {
+		int w = ltWinner(lt);
+		ListNode *taken = cursor[w];
+
+		cursor[w] = cursor[w]->next;
+		if (cursor[w] != NULL)
+			lt->keys[w] = cursor[w]->val;
+		else
+			lt->done[w] = true;
+
+		ltReplay(lt);
+		appendListNode(taken, out);
+	}
+
+	for (int i=0; i < k; i++)
+		detachList(lists[i]);
+
+	free(cursor);
+	ltFree(lt);
+	return out;
+}
+
+static int mergeSpans(Span *spans, int k, int *out, bool count) {
+	LoserTree *lt = ltCreate(k);
+	lt->count = count;
+	int *pos = (int*) calloc(k, sizeof(int));
+	assert(pos != NULL);
+	int n = 0;
+
+	for (int i=0; i < k; i++) {
+		lt->done[i] = (spans[i].len == 0);
+		if (spans[i].len > 0)
+			lt->keys[i] = spans[i].data[0];
+	}
+
+	ltInit(lt);
+
+	while (!ltEmpty(lt)) {
+		int w = ltWinner(lt);
+		out[n++] = lt->keys[w];
+
+		if (++pos[w] < spans[w].len)
+			lt->keys[w] = spans[w].data[pos[w]];
+		else
+			lt->done[w] = true;
+
+		ltReplay(lt);
+	}
+
+	free(pos);
+	ltFree(lt);
+	return n;
+}
+
+// merges k sorted spans into out, which must hold all of them; returns the count
+int mergeKArrays(Span *spans, int k, int *out) {
+	return mergeSpans(spans, k, out, true);
+}
+
+// split[i] = how many elements of span i are among the r smallest of all spans
+void coRank(Span *spans, int k, int64_t r, int *split) {
+	int64_t lo = INT_MIN, hi = INT_MAX;
+
+	// smallest key v with at least r elements <= v
+	while (lo < hi) {
+		int64_t mid = (lo + hi) >> 1;
+		int64_t atMost = 0;
+
+		for (int i=0; i < k; i++)
+			atMost += std::upper_bound(spans[i].data, spans[i].data + spans[i].len, (int) mid) - spans[i].data;
+
+		if (atMost >= r)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	int v = (int) lo;
+	int64_t taken = 0;
+
+	for (int i=0; i < k; i++) {
+		split[i] = std::lower_bound(spans[i].data, spans[i].data + spans[i].len, v) - spans[i].data;
+		taken += split[i];
+	}
+
+	// elements equal to v go to the lower spans first, like the loser tree ties
+	for (int i=0; i < k && taken < r; i++) {
+		int equal = std::upper_bound(spans[i].data, spans[i].data + spans[i].len, v) - spans[i].data - split[i];
+		int add = (int) std::min<int64_t>(equal, r - taken);
+		split[i] += add;
+		taken += add;
+	}
+}
+
+void parallelMergeKArrays(Span *spans, int k, int *out, int threads) {
+	int64_t n = 0;
+	for (int i=0; i < k; i++)
+		n += spans[i].len;
+
+	// 1. co-rank the p-1 inner boundaries, boundary 0 and p are trivial
+	std::vector<int> split((size_t) (threads + 1) * k);
+	std::vector<std::thread> pool;
+
+	for (int i=0; i < k; i++) {
+		split[i] = 0;
+		split[(size_t) threads * k + i] = spans[i].len;
+	}
+
+	for (int t=1; t < threads; t++)
+		pool.push_back(std::thread(coRank, spans, k, n * t / threads, &split[(size_t) t * k]));
+	for (auto &th : pool)
+		th.join();
+	pool.clear();
+
+	// 2. every thread merges the slices between its two boundaries
+	for (int t=0; t < threads; t++)
+		pool.push_back(std::thread([=, &split] {
+			Span *part = (Span*) malloc(k * sizeof(Span));
+			const int *from = &split[(size_t) t * k], *to = &split[(size_t) (t+1) * k];
+
+			for (int i=0; i < k; i++) {
+				part[i].data = spans[i].data + from[i];
+				part[i].len = to[i] - from[i];
+			}
+
+			mergeSpans(part, k, out + n * t / threads, false);
+			free(part);
+		}));
+	for (auto &th : pool)
+		th.join();
+}
+
+/*	merges k sorted runs into outFd from outOffset on, returns the number
+	of ints written or -1 on an IO error; holds 2 blocks of blockInts per
+	run and 2 for the output
+*/
+int64_t mergeKFiles(RunFile *runs, int k, int outFd, int64_t outOffset, int blockInts) {
+	BlockReader *readers = (BlockReader*) malloc(k * sizeof(BlockReader));
+	assert(readers != NULL);
+	Heap *minHeap = createHeap(k);
+	BlockWriter w;
+	int val;
+
+	for (int i=0; i < k; i++) {
+		readerOpen(&readers[i], runs[i].fd, runs[i].offset, runs[i].bytes, blockInts);
+		if (readerNext(&readers[i], &val))
+			insertHeapSource(val, i, minHeap);
+	}
+
+	buildMinHeapBU(minHeap);
+	writerOpen(&w, outFd, outOffset, blockInts);
+
+	while (minHeap->len > 0) {
+		writerPut(&w, minHeap->nodes[0].val);
+
+		if (readerNext(&readers[minHeap->nodes[0].src], &minHeap->nodes[0].val))
+			min_heapify(0, minHeap);
+		else
+			removeTopMinHeap(minHeap);
+	}
+
+	int64_t end = writerClose(&w);
+	bool ok = end >= 0;
+
+	for (int i=0; i < k; i++)
+		ok = readerClose(&readers[i]) && ok;
+
+	free(readers);
+	freeHeap(minHeap);
+	return ok ? (end - outOffset) / (int64_t) sizeof(int) : -1;
+}
+
+// lazy k-way merge, the lists are only read and must outlive the iterator
+typedef struct {
+	LoserTree *lt;
+	ListNode **cursor;
+} MergeIter;
+
+MergeIter* mergeIterCreate(List **lists, int k) {
+	MergeIter *it = (MergeIter*) malloc(sizeof(MergeIter));
+	assert(it != NULL);
+	it->lt = ltCreate(k);
+	it->cursor = (ListNode**) malloc(k * sizeof(ListNode*));
+	assert(it->cursor != NULL);
+
+	for (int i=0; i < k; i++) {
+		it->cursor[i] = lists[i]->first;
+		it->lt->done[i] = (it->cursor[i] == NULL);
+		if (it->cursor[i] != NULL)
+			it->lt->keys[i] = it->cursor[i]->val;
+	}
+
+	ltInit(it->lt);
+	return it;
+}
+
+// smallest value left without taking it, false once all lists are exhausted
+bool mergeIterPeek(MergeIter *it, int *val) {
+	if (ltEmpty(it->lt))
+		return false;
+
+	*val = it->lt->keys[ltWinner(it->lt)];
+	return true;
+}
+
+bool mergeIterNext(MergeIter *it, int *val) {
+	if (!mergeIterPeek(it, val))
+		return false;
+
+	int w = ltWinner(it->lt);
+	it->cursor[w] = it->cursor[w]->next;
+	if (it->cursor[w] != NULL)
+		it->lt->keys[w] = it->cursor[w]->val;
+	else
+		it->lt->done[w] = true;
+
+	ltReplay(it->lt);
+	return true;
+}
+
+void mergeIterFree(MergeIter *it) {
+	ltFree(it->lt);
+	free(it->cursor);
+	free(it);
+}
+
+// the n smallest values of all lists into out, returns how many there were
+int mergeTopN(List **lists, int k, int n, int *out) {
+	MergeIter *it = mergeIterCreate(lists, k);
+	int count = 0;
+
+	while (count < n && mergeIterNext(it, &out[count]))
+		count++;
+
+	mergeIterFree(it);
+	return count;
+}
+
+// every value <= maxKey, in order, into out; returns how many there were
+int mergeUntil(List **lists, int k, int maxKey, int *out) {
+	MergeIter *it = mergeIterCreate(lists, k);
+	int count = 0, val;
+
+	while (mergeIterPeek(it, &val) && val <= maxKey)
+		mergeIterNext(it, &out[count++]);
+
+	mergeIterFree(it);
+	return count;
+}
+
+// smallest key below the root, INT_MAX if the root is alone
+int runnerUp(Heap *heap) {
+	int best = INT_MAX;
+
+	if (H_LEFT(0) < heap->len)
+		best = getHeapVal(H_LEFT(0), heap);
+	if (H_RIGHT(0) < heap->len && getHeapVal(H_RIGHT(0), heap) < best)	// c++
+		best = getHeapVal(H_RIGHT(0), heap);
+
+	countOperations++;
+	return best;
+}
+
+// number of leading elements of a <= key, a[0] <= key is known
+int gallop(const int *a, int len, int key) {
+	int lo = 1, hi = 1;
+
+	// exponential search: a[lo-1] <= key, stop once a[hi] > key or past the end
+	while (hi < len && a[hi] <= key) {	// c++
+		countOperations++;
+		lo = hi + 1;
+		hi *= 2;
+	}
+	countOperations++;
+
+	if (hi > len)
+		hi = len;
+
+	// binary search for the first element > key in [lo, hi)
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		countOperations++;
+		if (a[mid] <= key)	// c++
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+// consumes the input lists, like mergeKLists
+List* mergeKListsGallop(List** lists, int k) {
+	Heap *minHeap = createHeap(k);
+
+	for (int i=0; i < k; i++)
+		if (lists[i]->first != NULL)
+			insertHeapNode(lists[i]->first, minHeap);
+
+	buildMinHeapBU(minHeap);
+
+	List* out = createList();
+
+	while (minHeap->len > 0) {
+		int bound = runnerUp(minHeap);
+		ListNode *first = minHeap->nodes[0].node, *last = first;
+		int count = 1;
+
+		// the run of the winner that still comes before the runner-up
+		while (last->next != NULL && last->next->val <= bound) {	// c++
+			countOperations++;
+			last = last->next;
+			count++;
+		}
+		countOperations++;
+
+		if (last->next != NULL) {
+			minHeap->nodes[0].node = last->next;
+			minHeap->nodes[0].val = last->next->val;
+			min_heapify(0, minHeap);
+		} else {
+			removeTopMinHeap(minHeap);
+		}
+
+		appendListChain(first, last, count, out);
+	}
+
+	for (int i=0; i < k; i++)
+		detachList(lists[i]);
+
 	freeHeap(minHeap);
 	return out;
 }
 
+// same result as mergeKArrays, whole runs are copied with memcpy
+int mergeKArraysGallop(Span *spans, int k, int *out) {
+	Heap *minHeap = createHeap(k);
+	int *pos = (int*) calloc(k, sizeof(int));
+	assert(pos != NULL);
+	int n = 0;
+
+	for (int i=0; i < k; i++)
+		if (spans[i].len > 0)
+			insertHeapSource(spans[i].data[0], i, minHeap);
+
+	buildMinHeapBU(minHeap);
+
+	while (minHeap->len > 0) {
+		int src = minHeap->nodes[0].src;
+		const int *run = spans[src].data + pos[src];
+		int len = gallop(run, spans[src].len - pos[src], runnerUp(minHeap));
+
+		memcpy(out + n, run, len * sizeof(int));
+		countOperations += len;
+		n += len;
+		pos[src] += len;
+
+		if (pos[src] < spans[src].len) {
+			minHeap->nodes[0].val = spans[src].data[pos[src]];
+			min_heapify(0, minHeap);
+		} else {
+			removeTopMinHeap(minHeap);
+		}
+	}
+
+	free(pos);
+	freeHeap(minHeap);
+	return n;
+}
+
+// consumes the input lists: their nodes are reused for the result
+UList* mergeKUnrolled(UList **lists, int k) {
+	LoserTree *lt = ltCreate(k);
+	UIter *cursor = (UIter*) malloc(k * sizeof(UIter));
+	assert(cursor != NULL);
+
+	for (int i=0; i < k; i++) {
+		cursor[i] = uListBegin(lists[i]);
+		lt->done[i] = (cursor[i].node == NULL);
+		if (cursor[i].node != NULL)
+			lt->keys[i] = cursor[i].node->vals[0];
+	}
+
+	ltInit(lt);
+
+	UList *out = createUList();
+
+	while (!ltEmpty(lt)) {
+		int w = ltWinner(lt);
+		UIter *c = &cursor[w];
+		uListAppend(lt->keys[w], out);
+
+		if (++c->i == c->node->count) {
+			UNode *used = c->node;
+			c->node = used->next;
+			c->i = 0;
+			releaseUNode(used);
+		}
+
+		if (c->node != NULL)
+			lt->keys[w] = c->node->vals[c->i];
+		else
+			lt->done[w] = true;
+
+		ltReplay(lt);
+	}
+
+	for (int i=0; i < k; i++) {
+		lists[i]->first = lists[i]->last = NULL;
+		lists[i]->len = 0;
+	}
+
+	free(cursor);
+	ltFree(lt);
+	return out;
+}
+
+int combineSum(int acc, int value) {
+	return acc + value;
+}
+
+int combineMax(int acc, int value) {
+	return value > acc ? value : acc;
+}
+
+// dedup: one entry per key, the heap does not order equal keys by run
+int combineFirst(int acc, int) {
+	return acc;
+}
+
+// moves the run on top of the heap to its next entry
+static inline void kvAdvance(KVSpan *spans, int *pos, Heap *minHeap) {
+	int src = minHeap->nodes[0].src;
+
+	if (++pos[src] < spans[src].len) {
+		minHeap->nodes[0].val = spans[src].data[pos[src]].key;
+		min_heapify(0, minHeap);
+	} else {
+		removeTopMinHeap(minHeap);
+	}
+}
+
+/*	merges k runs sorted by key into out, equal keys are folded with
+	combine before they are written (NULL keeps them all), so out only
+	needs room for the distinct keys; returns the number of entries written
+*/
+int mergeReduce(KVSpan *spans, int k, KeyValue *out, Combiner combine) {
+	Heap *minHeap = createHeap(k);
+	int *pos = (int*) calloc(k, sizeof(int));
+	assert(pos != NULL);
+	int n = 0;
+
+	for (int i=0; i < k; i++)
+		if (spans[i].len > 0)
+			insertHeapSource(spans[i].data[0].key, i, minHeap);
+
+	buildMinHeapBU(minHeap);
+
+	while (minHeap->len > 0) {
+		int src = minHeap->nodes[0].src;
+		KeyValue acc = spans[src].data[pos[src]];
+		kvAdvance(spans, pos, minHeap);
+
+		// the same key from other runs is on top right after it
+		while (combine != NULL && minHeap->len > 0 && minHeap->nodes[0].val == acc.key) {
+			src = minHeap->nodes[0].src;
+			acc.value = combine(acc.value, spans[src].data[pos[src]].value);
+			kvAdvance(spans, pos, minHeap);
+		}
+
+		out[n++] = acc;
+	}
+
+	free(pos);
+	freeHeap(minHeap);
+	return n;
+}
+
+// the separate pass mergeReduce saves: folds equal neighbours of a in place
+int reduceSorted(KeyValue *a, int n, Combiner combine) {
+	int m = 0;
+
+	for (int i=0; i < n; i++)
+		if (combine != NULL && m > 0 && a[m-1].key == a[i].key)
+			a[m-1].value = combine(a[m-1].value, a[i].value);
+		else
+			a[m++] = a[i];
+
+	return m;
+}
+
+typedef struct MergeNode {
+	struct MergeNode *left, *right;	// NULL for leaves
+	const int *data;	// leaf: its span, inner node: buf
+	int pos, len;		// data[pos..len) is ready
+	int *buf, cap;
+	bool final;			// nothing comes after data[len-1]
+} MergeNode;
+
+MergeNode* buildMergeTree(Span *spans, int lo, int hi, int *out, int cap) {
+	MergeNode *node = (MergeNode*) calloc(1, sizeof(MergeNode));
+	assert(node != NULL);
+
+	if (hi - lo == 1) {
+		node->data = spans[lo].data;
+		node->len = spans[lo].len;
+		node->final = true;
+		return node;
+	}
+
+	int mid = lo + (hi - lo) / 2;
+	node->left = buildMergeTree(spans, lo, mid, NULL, MERGE_TREE_BUF);
+	node->right = buildMergeTree(spans, mid, hi, NULL, MERGE_TREE_BUF);
+
+	node->buf = out != NULL ? out : (int*) malloc(cap * sizeof(int));
+	assert(node->buf != NULL);
+	node->data = node->buf;
+	node->cap = cap;
+	return node;
+}
+
+void freeMergeTree(MergeNode *node, int *out) {
+	if (node->left != NULL) {
+		freeMergeTree(node->left, out);
+		freeMergeTree(node->right, out);
+	}
+	if (node->buf != out)
+		free(node->buf);
+	free(node);
+}
+
+static inline bool mergeNodeEmpty(MergeNode *node) {
+	return node->pos == node->len;
+}
+
+// keys of the chunk data[pos..len) that are <= key
+static int chunkAtMost(MergeNode *node, int key) {
+	return std::upper_bound(node->data + node->pos, node->data + node->len, key) - (node->data + node->pos);
+}
+
+// refills an inner node whose buffer was used up
+void refillMergeNode(MergeNode *node, Merge2Fn merge2) {
+	MergeNode *a = node->left, *b = node->right;
+	node->pos = node->len = 0;
+
+	while (node->len < node->cap) {
+		if (mergeNodeEmpty(a) && !a->final)
+			refillMergeNode(a, merge2);
+		if (mergeNodeEmpty(b) && !b->final)
+			refillMergeNode(b, merge2);
+
+		int na = a->len - a->pos, nb = b->len - b->pos;
+		if (na == 0 && nb == 0) {
+			node->final = true;
+			return;
+		}
+
+		// a key can go out if it is <= the last buffered key of every child that is not final
+		int r;
+		if (a->final && b->final)
+			r = na + nb;
+		else {
+			int bound = !a->final && (b->final || a->data[a->len-1] < b->data[b->len-1])
+				? a->data[a->len-1] : b->data[b->len-1];
+			r = chunkAtMost(a, bound) + chunkAtMost(b, bound);
+		}
+		if (r > node->cap - node->len)
+			r = node->cap - node->len;
+
+		int ra = merge2_corank(a->data + a->pos, na, b->data + b->pos, nb, r);
+		merge2(a->data + a->pos, ra, b->data + b->pos, r - ra, node->buf + node->len);
+
+		a->pos += ra;
+		b->pos += r - ra;
+		node->len += r;
+	}
+
+	node->final = a->final && b->final && mergeNodeEmpty(a) && mergeNodeEmpty(b);
+}
+
+// same result as mergeKArrays; merge2 = NULL picks the SIMD kernel of this CPU
+int mergeKTree(Span *spans, int k, int *out, Merge2Fn merge2 = NULL) {
+	int n = 0;
+	for (int i=0; i < k; i++)
+		n += spans[i].len;
+
+	if (k == 1) {
+		memcpy(out, spans[0].data, n * sizeof(int));
+		return n;
+	}
+
+	MergeNode *root = buildMergeTree(spans, 0, k, out, n);
+	refillMergeNode(root, merge2 != NULL ? merge2 : merge2_simd);
+	assert(root->len == n);
+
+	freeMergeTree(root, out);
+	return n;
+}
+
+// one span per run of data, see fillSortedRuns
+void runsToSpans(int *data, int *sizes, int k, Span *spans) {
+	for (int i=0, offset=0; i < k; offset += sizes[i], i++) {
+		spans[i].data = data + offset;
+		spans[i].len = sizes[i];
+	}
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
 // generate k integers s.t. their sum is n
 void generateSizes(int k, int n, int* arr) {
 	double *tmp = (double*) malloc(k * sizeof(double));
-	FillRandomArray(tmp, k, 1.0, 1000.0, false, 0);
+	rngFillDoubles(tmp, k, 1.0, 1000.0);
 
 	double sum = 0;
 	int arrSum = 0;
@@ -327,15 +1298,32 @@ void generateSizes(int k, int n, int* arr) {
 	free(tmp);
 }
 
+// k ascending runs back to back in data, run i has sizes[i] elements
+void fillSortedRuns(int *data, int *sizes, int k) {
+	for (int i=0, offset=0; i < k; offset += sizes[i], i++)
+		rngFillArray(data + offset, sizes[i], RANGE_MIN, RANGE_MAX, false, ASCENDING);
+}
+
+void runsToLists(int *data, int *sizes, int k, List **lists) {
+	for (int i=0, offset=0; i < k; offset += sizes[i], i++)
+		lists[i] = arrayToList(data + offset, sizes[i]);
+}
+
+void freeLists(List **lists, int k) {
+	for (int i=0; i < k; i++)
+		freeList(lists[i]);
+}
+
 void demo() {
 	int sizes[] = { 3, 3, 3 };
 	int k = sizeof(sizes) / sizeof(int);
+	int data[9];
 	List *lists[k], *out;
 
+	fillSortedRuns(data, sizes, k);
+	runsToLists(data, sizes, k, lists);
+
 	for (int i=0; i < k; i++) {
-		int arr[sizes[i]];
-		FillRandomArray(arr, sizes[i], RANGE_MIN, RANGE_MAX, false, ASCENDING);
-		lists[i] = arrayToList(arr, sizes[i]);
 		printf("List %d of size %d: ", i+1, lists[i]->len);
 		printList(lists[i]);
 	}
@@ -344,15 +1332,62 @@ void demo() {
 
 	printf("Merged list: ");
 	printList(out);
+	freeLists(lists, k);
+
+	runsToLists(data, sizes, k, lists);
+	List *outLT = mergeKListsLT(lists, k);
+	printf("Loser tree:  ");
+	printList(outLT);
+	assert(listsEqual(out, outLT));
+
+	Span spans[k];
+	int merged[9], mergedPar[9];
+	runsToSpans(data, sizes, k, spans);
+	int mergedLen = mergeKArrays(spans, k, merged);
+	assert(mergedLen == out->len);
+	(void) mergedLen;
+	parallelMergeKArrays(spans, k, mergedPar, 4);
+	for (int i=0; i < 9; i++)
+		assert(mergedPar[i] == merged[i]);
+
+	printf("Array merge: ");
+	ListNode *trav = out->first;
+	for (int i=0; i < out->len; i++, trav = trav->next) {
+		assert(merged[i] == trav->val);
+		printf("%d ", merged[i]);
+	}
+	printf("\n");
 
-	for (int i=0; i < k; i++)
-		freeList(lists[i]);
+	// the iterator only reads the lists, so it can run on out itself
+	int first[4], small[9];
+	List *one[] = { out };
+	int got = mergeTopN(one, 1, 4, first);
+	assert(got == 4);
+	(void) got;
+	int cnt = mergeUntil(one, 1, merged[4], small);
+	assert(cnt >= 5);
+
+	printf("First 4:     ");
+	for (int i=0; i < 4; i++) {
+		assert(first[i] == merged[i]);
+		printf("%d ", first[i]);
+	}
+	printf("\n<= %d:   ", merged[4]);
+	for (int i=0; i < cnt; i++) {
+		assert(small[i] == merged[i]);
+		printf("%d ", small[i]);
+	}
+	printf("\n");
 
+	freeLists(lists, k);
 	freeList(out);
+	freeList(outLT);
+	poolRelease();
 }
 
 void first_test() {
 	char *series[] = { "k_5", "k_10", "k_100"};
+	char *seriesLT[] = { "k_5_loser_tree", "k_10_loser_tree", "k_100_loser_tree"};
 	int kValues[] = {5, 10, 100, 0};
 	int k;
 
@@ -367,72 +1402,593 @@ void first_test() {
 			k = kValues[k_index];
 			List *lists[k], *out;
 			int *listSizes = (int*) malloc(k * sizeof(int));
+			int *data = (int*) malloc(dim * sizeof(int));
 
 			generateSizes(k, dim, listSizes);
+			fillSortedRuns(data, listSizes, k);
+			runsToLists(data, listSizes, k, lists);
 
-			for (int i=0; i < k; i++) {
-				int arr[listSizes[i]];
-				FillRandomArray(arr, listSizes[i], RANGE_MIN, RANGE_MAX, false, ASCENDING);
-				lists[i] = arrayToList(arr, listSizes[i]);
-
-
-				if (VERBOSE_DEBUG) {
+			if (VERBOSE_DEBUG)
+				for (int i=0; i < k; i++) {
 					printf("List %d of size %d: ", i+1, lists[i]->len);
 					printList(lists[i]);
 				}
-			}
 
 			countOperations = 0;
 			out = mergeKLists(lists, k);
 			profiler.countOperation(series[k_index], dim, countOperations);
+			freeLists(lists, k);
 
-			for (int i=0; i < k; i++)
-				freeList(lists[i]);
+			runsToLists(data, listSizes, k, lists);
+			countOperations = 0;
+			List *outLT = mergeKListsLT(lists, k);
+			profiler.countOperation(seriesLT[k_index], dim, countOperations);
+			assert(listsEqual(out, outLT));
 
+			freeLists(lists, k);
 			freeList(out);
+			freeList(outLT);
 			free(listSizes);
+			free(data);
 		}
 	}
 
+	poolRelease();
+
 
 	profiler.createGroup("First_Test", series[0], series[1], series[2]);
+	profiler.createGroup("First_Test_Loser_Tree", seriesLT[0], seriesLT[1], seriesLT[2]);
+	profiler.createGroup("First_Test_k_100", series[2], seriesLT[2]);
 
 }
 
 void second_test() {
-	char *series[] = {"n_10000" };
+	char *series[] = {"n_10000", "n_10000_loser_tree" };
 	int dim = DIM_MAX;
 
 	for (int k=10; k <= 500; k += 10) {
 
 		List *lists[k], *out;
 		int listSizes[k];
+		int data[dim];
 
 		generateSizes(k, dim, listSizes);
-
-		for (int i=0; i < k; i++) {
-			int arr[listSizes[i]];
-			FillRandomArray(arr, listSizes[i], RANGE_MIN, RANGE_MAX, false, ASCENDING);
-			lists[i] = arrayToList(arr, listSizes[i]);
-		}
+		fillSortedRuns(data, listSizes, k);
+		runsToLists(data, listSizes, k, lists);
 
 		countOperations = 0;
 		out = mergeKLists(lists, k);
 		profiler.countOperation(series[0], k, countOperations);
+		freeLists(lists, k);
 
-		for (int i=0; i < k; i++)
-			freeList(lists[i]);
+		runsToLists(data, listSizes, k, lists);
+		countOperations = 0;
+		List *outLT = mergeKListsLT(lists, k);
+		profiler.countOperation(series[1], k, countOperations);
+		assert(listsEqual(out, outLT));
 
+		freeLists(lists, k);
 		freeList(out);
+		freeList(outLT);
+	}
+
+	poolRelease();
+
+	profiler.createGroup("Second_Test", series[0], series[1]);
+}
+
+// wall time: converting runs to lists and merging them vs merging the arrays
+void array_test() {
+	int n = ARRAY_TEST_N;
+	int *data = (int*) malloc(n * sizeof(int));
+	int *out = (int*) malloc(n * sizeof(int));
+	assert(data != NULL && out != NULL);
+
+	printf("\nmerging %d elements (ms)\n", n);
+	printf("%6s | %12s | %12s | %12s\n", "k", "arrayToList", "list_merge", "array_merge");
+
+	for (int k=2; k <= 1024; k *= 2) {
+		int *sizes = (int*) malloc(k * sizeof(int));
+		List **lists = (List**) malloc(k * sizeof(List*));
+		Span *spans = (Span*) malloc(k * sizeof(Span));
+
+		generateSizes(k, n, sizes);
+		fillSortedRuns(data, sizes, k);
+
+		auto start = std::chrono::steady_clock::now();
+		runsToLists(data, sizes, k, lists);
+		double convertMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		List *merged = mergeKListsLT(lists, k);
+		double listMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		runsToSpans(data, sizes, k, spans);
+		int outLen = mergeKArrays(spans, k, out);
+		double arrayMs = ms_since(start);
+		assert(outLen == n);
+		(void) outLen;
+
+		assert(IsSorted(out, n));
+		ListNode *trav = merged->first;
+		for (int i=0; i < n; i++, trav = trav->next)
+			assert(out[i] == trav->val);
+
+		printf("%6d | %12.1f | %12.1f | %12.1f\n", k, convertMs, listMs, arrayMs);
+
+		freeLists(lists, k);
+		freeList(merged);
+		poolRelease();
+		free(sizes);
+		free(lists);
+		free(spans);
+	}
+
+	free(data);
+	free(out);
+}
+
+void parallel_test() {
+	int n = PARALLEL_TEST_N;
+	int kValues[] = { 16, 256, 4096 };
+	int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	int *data = (int*) malloc((size_t) n * sizeof(int));
+	int *out = (int*) malloc((size_t) n * sizeof(int));
+	int *check = (int*) malloc((size_t) n * sizeof(int));
+	assert(data != NULL && out != NULL && check != NULL);
+
+	printf("\nparallel merge of %d elements\n", n);
+	printf("%6s | %8s | %10s | %8s\n", "k", "threads", "ms", "speedup");
+
+	for (int ki=0; ki < 3; ki++) {
+		int k = kValues[ki];
+		int *sizes = (int*) malloc(k * sizeof(int));
+		Span *spans = (Span*) malloc(k * sizeof(Span));
+
+		generateSizes(k, n, sizes);
+		fillSortedRuns(data, sizes, k);
+		runsToSpans(data, sizes, k, spans);
+		mergeKArrays(spans, k, check);
+
+		double baseMs = 0;
+		for (int threads=1; threads <= 2 * maxThreads; threads *= 2) {
+			auto start = std::chrono::steady_clock::now();
+			parallelMergeKArrays(spans, k, out, threads);
+			double ms = ms_since(start);
+
+			if (threads == 1)
+				baseMs = ms;
+			assert(memcmp(out, check, (size_t) n * sizeof(int)) == 0);
+
+			printf("%6d | %8d | %10.1f | %8.2f\n", k, threads, ms, baseMs / ms);
+		}
+
+		free(sizes);
+		free(spans);
+	}
+
+	free(data);
+	free(out);
+	free(check);
+}
+
+// operations of the first N elements through MergeIter vs a full merge
+void iter_test() {
+	int n = DIM_MAX * 10, k = 100;
+	int nValues[] = { 10, 100, 1000, 10000, n };
+	int *data = (int*) malloc(n * sizeof(int));
+	int *out = (int*) malloc(n * sizeof(int));
+	int sizes[k];
+	List *lists[k];
+	assert(data != NULL && out != NULL);
+
+	generateSizes(k, n, sizes);
+	fillSortedRuns(data, sizes, k);
+	runsToLists(data, sizes, k, lists);
+
+	printf("\nfirst N of %d elements in %d lists (operations)\n", n, k);
+	printf("%8s | %12s\n", "N", "mergeTopN");
+
+	for (int i=0; i < 5; i++) {
+		countOperations = 0;
+		int got = mergeTopN(lists, k, nValues[i], out);
+		assert(got == nValues[i]);
+		(void) got;
+		printf("%8d | %12u\n", nValues[i], countOperations);
+	}
+
+	countOperations = 0;
+	List *merged = mergeKListsLT(lists, k);
+	printf("%8s | %12u\n", "full", countOperations);
+
+	ListNode *trav = merged->first;
+	for (int i=0; i < n; i++, trav = trav->next)
+		assert(out[i] == trav->val);
+
+	freeLists(lists, k);
+	freeList(merged);
+	poolRelease();
+	free(data);
+	free(out);
+}
+
+/*	the run layouts of gallop_test:
+	0 random:      generateSizes, keys from the whole range
+	1 skewed:      one list holds 90% of the elements
+	2 disjoint:    random sizes, list i holds the i-th slice of the keys
+	3 interleaved: equal sizes, list i holds the keys = i mod k
+*/
+void fillGallopRuns(int layout, int *data, int *sizes, int k, int n) {
+	if (layout == 1) {
+		generateSizes(k-1, n - n/10*9, sizes + 1);
+		sizes[0] = n/10*9;
+	} else if (layout == 3) {
+		for (int i=0; i < k; i++)
+			sizes[i] = n / k + (i < n % k);
+	} else {
+		generateSizes(k, n, sizes);
+	}
+
+	if (layout == 2) {
+		for (int i=0, offset=0; i < k; offset += sizes[i], i++)
+			rngFillArray(data + offset, sizes[i], i * (RANGE_MAX / k), (i+1) * (RANGE_MAX / k) - 1, false, ASCENDING);
+	} else if (layout == 3) {
+		for (int i=0, offset=0; i < k; offset += sizes[i], i++)
+			for (int j=0; j < sizes[i]; j++)
+				data[offset + j] = j * k + i;
+	} else {
+		fillSortedRuns(data, sizes, k);
+	}
+}
+
+// operations and wall time of the heap merges with and without galloping
+void gallop_test() {
+	int n = GALLOP_TEST_N, k = GALLOP_TEST_K;
+	const char *layouts[] = { "random", "skewed", "disjoint", "interleaved" };
+	int *data = (int*) malloc(n * sizeof(int));
+	int *out = (int*) malloc(n * sizeof(int));
+	int *check = (int*) malloc(n * sizeof(int));
+	int sizes[k];
+	List *lists[k];
+	Span spans[k];
+	assert(data != NULL && out != NULL && check != NULL);
+
+	printf("\ngalloping, %d elements in %d lists\n", n, k);
+	printf("%12s | %-14s | %12s | %10s\n", "layout", "merge", "operations", "ms");
+
+	for (int layout=0; layout < 4; layout++) {
+		fillGallopRuns(layout, data, sizes, k, n);
+		runsToSpans(data, sizes, k, spans);
+
+		runsToLists(data, sizes, k, lists);
+		countOperations = 0;
+		auto start = std::chrono::steady_clock::now();
+		List *plain = mergeKLists(lists, k);
+		printf("%12s | %-14s | %12u | %10.1f\n", layouts[layout], "list", countOperations, ms_since(start));
+		freeLists(lists, k);
+
+		runsToLists(data, sizes, k, lists);
+		countOperations = 0;
+		start = std::chrono::steady_clock::now();
+		List *galloped = mergeKListsGallop(lists, k);
+		printf("%12s | %-14s | %12u | %10.1f\n", "", "list_gallop", countOperations, ms_since(start));
+		assert(listsEqual(plain, galloped));
+		freeLists(lists, k);
+
+		countOperations = 0;
+		start = std::chrono::steady_clock::now();
+		mergeKArrays(spans, k, check);
+		printf("%12s | %-14s | %12u | %10.1f\n", "", "array", countOperations, ms_since(start));
+
+		countOperations = 0;
+		start = std::chrono::steady_clock::now();
+		int outLen = mergeKArraysGallop(spans, k, out);
+		printf("%12s | %-14s | %12u | %10.1f\n", "", "array_gallop", countOperations, ms_since(start));
+		assert(outLen == n && memcmp(out, check, n * sizeof(int)) == 0);
+		(void) outLen;
+
+		freeList(plain);
+		freeList(galloped);
+		poolRelease();
+	}
+
+	free(data);
+	free(out);
+	free(check);
+}
+
+// wall time of the heap list merge, the loser tree array merge and the merge trees
+void simd_test() {
+	int n = SIMD_TEST_N;
+	int *data = (int*) malloc(n * sizeof(int));
+	int *out = (int*) malloc(n * sizeof(int));
+	int *check = (int*) malloc(n * sizeof(int));
+	assert(data != NULL && out != NULL && check != NULL);
+
+	printf("\nmerging %d elements (ms), two-way kernel: %s\n", n,
+		merge2_simd == merge2_scalar ? "scalar" : merge2_simd == merge2_avx2 ? "avx2" : "avx512");
+	printf("%6s | %12s | %12s | %12s | %12s\n", "k", "mergeKLists", "array_lt", "tree_scalar", "tree_simd");
+
+	for (int k=2; k <= 1024; k *= 2) {
+		int *sizes = (int*) malloc(k * sizeof(int));
+		List **lists = (List**) malloc(k * sizeof(List*));
+		Span *spans = (Span*) malloc(k * sizeof(Span));
+
+		generateSizes(k, n, sizes);
+		fillSortedRuns(data, sizes, k);
+		runsToSpans(data, sizes, k, spans);
+		runsToLists(data, sizes, k, lists);
+
+		auto start = std::chrono::steady_clock::now();
+		List *merged = mergeKLists(lists, k);
+		double listMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		mergeKArrays(spans, k, check);
+		double ltMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		mergeKTree(spans, k, out, merge2_scalar);
+		double scalarMs = ms_since(start);
+		assert(memcmp(out, check, n * sizeof(int)) == 0);
+
+		memset(out, 0, n * sizeof(int));
+		start = std::chrono::steady_clock::now();
+		mergeKTree(spans, k, out);
+		double simdMs = ms_since(start);
+		assert(memcmp(out, check, n * sizeof(int)) == 0);
+
+		ListNode *trav = merged->first;
+		for (int i=0; i < n; i++, trav = trav->next)
+			assert(out[i] == trav->val);
+
+		printf("%6d | %12.1f | %12.1f | %12.1f | %12.1f\n", k, listMs, ltMs, scalarMs, simdMs);
+
+		freeLists(lists, k);
+		freeList(merged);
+		poolRelease();
+		free(sizes);
+		free(lists);
+		free(spans);
+	}
+
+	free(data);
+	free(out);
+	free(check);
+}
+
+// memory, build, merge and scan time of List vs UList
+void unrolled_test() {
+	int n = UNROLLED_TEST_N;
+	int kValues[] = { 4, 64, 1024 };
+	int *data = (int*) malloc(n * sizeof(int));
+	assert(data != NULL);
+
+	printf("\n%d elements, %d values per unrolled node\n", n, UNROLLED_VALUES);
+	printf("%6s | %-8s | %8s | %10s | %10s | %10s | %12s\n",
+		"k", "format", "MB", "build_ms", "merge_ms", "scan_ms", "Melem/s");
+
+	for (int ki=0; ki < 3; ki++) {
+		int k = kValues[ki];
+		int *sizes = (int*) malloc(k * sizeof(int));
+		List **lists = (List**) malloc(k * sizeof(List*));
+		UList **ulists = (UList**) malloc(k * sizeof(UList*));
+
+		generateSizes(k, n, sizes);
+		fillSortedRuns(data, sizes, k);
+
+		// List
+		auto start = std::chrono::steady_clock::now();
+		runsToLists(data, sizes, k, lists);
+		double buildMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		List *merged = mergeKListsLT(lists, k);
+		double mergeMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		long long sum = 0;
+		for (ListNode *p = merged->first; p != NULL; p = p->next)
+			sum += p->val;
+		double scanMs = ms_since(start);
+
+		double mb = (double) n * sizeof(ListNode) / (1 << 20);
+		printf("%6d | %-8s | %8.1f | %10.1f | %10.1f | %10.1f | %12.1f\n",
+			k, "List", mb, buildMs, mergeMs, scanMs, n / mergeMs / 1000);
+
+		// UList
+		start = std::chrono::steady_clock::now();
+		for (int i=0, offset=0; i < k; offset += sizes[i], i++)
+			ulists[i] = arrayToUList(data + offset, sizes[i]);
+		buildMs = ms_since(start);
+
+		int nodes = 0;
+		for (int i=0; i < k; i++)
+			nodes += (sizes[i] + UNROLLED_VALUES - 1) / UNROLLED_VALUES;
+
+		start = std::chrono::steady_clock::now();
+		UList *umerged = mergeKUnrolled(ulists, k);
+		mergeMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		long long usum = 0;
+		int val;
+		UIter it = uListBegin(umerged);
+		while (uIterNext(&it, &val))
+			usum += val;
+		scanMs = ms_since(start);
+
+		mb = (double) nodes * sizeof(UNode) / (1 << 20);
+		printf("%6s | %-8s | %8.1f | %10.1f | %10.1f | %10.1f | %12.1f\n",
+			"", "UList", mb, buildMs, mergeMs, scanMs, n / mergeMs / 1000);
+
+		assert(sum == usum && umerged->len == n);
+		it = uListBegin(umerged);
+		for (ListNode *p = merged->first; p != NULL; p = p->next) {
+			bool more = uIterNext(&it, &val);
+			assert(more && val == p->val);
+			(void) more;
+		}
+
+		freeLists(lists, k);
+		freeList(merged);
+		for (int i=0; i < k; i++)
+			freeUList(ulists[i]);
+		freeUList(umerged);
+		poolRelease();
+		free(sizes);
+		free(lists);
+		free(ulists);
+	}
+
+	free(data);
+}
+
+// merge then reduce vs mergeReduce, counts summed, for several key ranges
+void reduce_test() {
+	int n = REDUCE_TEST_N, k = 64;
+	int distinct[] = { 1000, 100000, n };
+	KeyValue *data = (KeyValue*) malloc(n * sizeof(KeyValue));
+	KeyValue *out = (KeyValue*) malloc(n * sizeof(KeyValue));
+	KeyValue *check = (KeyValue*) malloc(n * sizeof(KeyValue));
+	int *keys = (int*) malloc(n * sizeof(int));
+	int sizes[k];
+	KVSpan spans[k];
+	assert(data != NULL && out != NULL && check != NULL && keys != NULL);
+
+	printf("\nmerge-reduce of %d (key, count) entries in %d runs\n", n, k);
+	printf("%10s | %10s | %14s | %14s | %10s\n", "keys", "out_len", "merge+pass_ms", "mergeReduce_ms", "speedup");
+
+	for (int di=0; di < 3; di++) {
+		generateSizes(k, n, sizes);
+
+		for (int i=0, offset=0; i < k; offset += sizes[i], i++) {
+			rngFillArray(keys + offset, sizes[i], 1, distinct[di], false, ASCENDING);
+			for (int j=0; j < sizes[i]; j++) {
+				data[offset + j].key = keys[offset + j];
+				data[offset + j].value = 1;
+			}
+			spans[i].data = data + offset;
+			spans[i].len = sizes[i];
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		int len = reduceSorted(check, mergeReduce(spans, k, check, NULL), combineSum);
+		double twoPassMs = ms_since(start);
+
+		start = std::chrono::steady_clock::now();
+		int reduced = mergeReduce(spans, k, out, combineSum);
+		double reduceMs = ms_since(start);
+
+		assert(reduced == len);
+		(void) reduced;
+		long long total = 0;
+		for (int i=0; i < len; i++) {
+			assert(out[i].key == check[i].key && out[i].value == check[i].value);
+			assert(i == 0 || out[i-1].key < out[i].key);
+			total += out[i].value;
+		}
+		assert(total == n);
+
+		printf("%10d | %10d | %14.1f | %14.1f | %10.2f\n", distinct[di], len, twoPassMs, reduceMs, twoPassMs / reduceMs);
+	}
+
+	free(data);
+	free(out);
+	free(check);
+	free(keys);
+}
+
+// a temporary file that is removed on close
+int tempFile() {
+	char path[256];
+	sprintf(path, "%s/lab4-run-XXXXXX", FILE_TEST_DIR);
+
+	int fd = mkstemp(path);
+	assert(fd >= 0);
+	unlink(path);
+	return fd;
+}
+
+// wall time of merging k run files vs merging the same runs in memory
+void file_test() {
+	int n = FILE_TEST_N;
+	int kValues[] = { 8, 64, 256 };
+	int *data = (int*) malloc((size_t) n * sizeof(int));
+	int *out = (int*) malloc((size_t) n * sizeof(int));
+	int *check = (int*) malloc((size_t) n * sizeof(int));
+	assert(data != NULL && out != NULL && check != NULL);
+
+	printf("\nmerging %d ints from run files, %d KB blocks\n", n, (int) (FILE_BLOCK_INTS * sizeof(int) / 1024));
+	printf("%6s | %10s | %12s | %12s | %10s\n", "k", "file_ms", "array_ms", "MB/s", "buffer_MB");
+
+	for (int ki=0; ki < 3; ki++) {
+		int k = kValues[ki];
+		int *sizes = (int*) malloc(k * sizeof(int));
+		Span *spans = (Span*) malloc(k * sizeof(Span));
+		RunFile *runs = (RunFile*) malloc(k * sizeof(RunFile));
+
+		generateSizes(k, n, sizes);
+		fillSortedRuns(data, sizes, k);
+		runsToSpans(data, sizes, k, spans);
+
+		for (int i=0; i < k; i++) {
+			runs[i].fd = tempFile();
+			runs[i].offset = 0;
+			runs[i].bytes = (int64_t) sizes[i] * sizeof(int);
+			bool written = blockFlush(runs[i].fd, (int*) spans[i].data, runs[i].bytes, 0);
+			assert(written);
+			(void) written;
+		}
+
+		int outFd = tempFile();
+
+		auto start = std::chrono::steady_clock::now();
+		int64_t merged = mergeKFiles(runs, k, outFd, 0, FILE_BLOCK_INTS);
+		double fileMs = ms_since(start);
+		assert(merged == n);
+		(void) merged;
+
+		start = std::chrono::steady_clock::now();
+		mergeKArrays(spans, k, check);
+		double arrayMs = ms_since(start);
+
+		int len;
+		bool readBack = blockFill(outFd, out, &len, 0, (int64_t) n * sizeof(int));
+		assert(readBack && memcmp(out, check, (size_t) n * sizeof(int)) == 0);
+		(void) readBack;
+
+		double mb = (double) n * sizeof(int) / (1 << 20);
+		double bufferMb = 2.0 * (k + 1) * FILE_BLOCK_INTS * sizeof(int) / (1 << 20);
+		printf("%6d | %10.1f | %12.1f | %12.1f | %10.1f\n", k, fileMs, arrayMs, mb / fileMs * 1000, bufferMb);
+
+		for (int i=0; i < k; i++)
+			close(runs[i].fd);
+		close(outFd);
+		free(sizes);
+		free(spans);
+		free(runs);
 	}
 
-	profiler.createGroup("Second_Test", series[0]);
+	free(data);
+	free(out);
+	free(check);
 }
 
 int main() {
+	rngSeed(RNG_SEED);
 	demo();
 	// first_test();
 	// second_test();
+	// array_test();
+	// parallel_test();
+	// file_test();
+	// iter_test();
+	// gallop_test();
+	// simd_test();
+	// unrolled_test();
+	// reduce_test();
 
 	// profiler.showReport();
 	return 0;
@@ -0,0 +1,116 @@
+/*	Loser tree (tournament tree) for k-way merging.
+
+	- the k sources are the leaves k..2k-1 of an implicit binary tree,
+	  every internal node 1..k-1 keeps the source that LOST the match
+	  played there and tree[0] keeps the overall winner
+	- after the caller advances the winner, ltReplay() walks the single
+	  leaf-to-root path of that source and plays one match per level:
+	  ceil(log2 k) comparisons per element, no swaps of whole nodes
+	- an exhausted source is a sentinel that loses every match, so
+	  nothing has to be removed from the tree
+	- the tree only stores source indices, the caller keeps keys[i] and
+	  done[i] up to date, so lists, arrays or files can all be merged
+
+	countOperations (lab file): c++ per match, a++ per loser update;
+	trees used from several threads at once must set count = false
+*/
+
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+#include <cstdlib>
+#include <cassert>
+
+extern unsigned int countOperations;
+
+typedef struct {
+	int k;
+	int *tree;		// tree[0] winner, tree[1..k-1] losers
+	int *keys;		// current key of every source
+	bool *done;		// source exhausted
+	bool count;		// update countOperations
+} LoserTree;
+
+LoserTree* ltCreate(int k) {
+	assert(k > 0);
+	LoserTree *t = (LoserTree*) malloc(sizeof(LoserTree));
+	assert(t != NULL);
+
+	t->k = k;
+	t->tree = (int*) calloc(k, sizeof(int));
+	t->keys = (int*) calloc(k, sizeof(int));
+	t->done = (bool*) calloc(k, sizeof(bool));
+	assert(t->tree != NULL && t->keys != NULL && t->done != NULL);
+	t->count = true;
+
+	return t;
+}
+
+void ltFree(LoserTree *t) {
+	free(t->tree);
+	free(t->keys);
+	free(t->done);
+	free(t);
+}
+
+// true if source a beats source b; ties go to the lower index (stable)
+static inline bool ltBeats(LoserTree *t, int a, int b) {
+	if (t->count)
+		countOperations++;	// c++
+
+	if (t->done[a])
+		return false;
+	if (t->done[b])
+		return true;
+	if (t->keys[a] != t->keys[b])
+		return t->keys[a] < t->keys[b];
+
+	return a < b;
+}
+
+static int ltPlay(LoserTree *t, int node) {
+	if (node >= t->k)
+		return node - t->k;
+
+	int a = ltPlay(t, 2*node);
+	int b = ltPlay(t, 2*node + 1);
+
+	if (ltBeats(t, a, b)) {
+		t->tree[node] = b;
+		return a;
+	}
+
+	t->tree[node] = a;
+	return b;
+}
+
+// plays the whole tournament, keys[] and done[] must be filled in
+void ltInit(LoserTree *t) {
+	t->tree[0] = t->k == 1 ? 0 : ltPlay(t, 1);
+}
+
+static inline int ltWinner(LoserTree *t) {
+	return t->tree[0];
+}
+
+static inline bool ltEmpty(LoserTree *t) {
+	return t->done[t->tree[0]];
+}
+
+// call after keys[] / done[] of the winner changed
+void ltReplay(LoserTree *t) {
+	int w = t->tree[0];
+
+	for (int node = (w + t->k) / 2; node >= 1; node /= 2)
+		if (ltBeats(t, t->tree[node], w)) {
+			int tmp = t->tree[node];
+			t->tree[node] = w;
+			w = tmp;
+			if (t->count)
+				countOperations++;	// a++
+		}
+
+	t->tree[0] = w;
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*	Vectorized two-way merge of sorted int arrays.
+
+	- the main loop keeps the W largest keys seen so far in a register:
+	  the next vector is loaded from the input with the smaller head, a
+	  bitonic network merges it with the register, the lower W keys are
+	  stored and the upper W stay for the next step (W = 8 with AVX2,
+	  16 with AVX-512)
+	- the network: reverse one side, one min/max to split into two
+	  bitonic halves, then log2(W) min/max stages with shuffles at
+	  distance W/2 .. 1; no branch depends on the keys
+	- when one input has fewer than W keys left the keys in the register
+	  are given back: everything stored so far is the smallest o keys of
+	  both inputs, so a merge path search (merge2_corank) finds where each
+	  input stands after o keys and the rest is merged in scalar code
+	- the version is picked once at runtime (common/cpu.h), the scalar
+	  fallback is a branchless merge
+
+	countOperations: one comparison and one write per key
+*/
+
+#ifndef SIMD_MERGE_H
+#define SIMD_MERGE_H
+
+#include "../common/cpu.h"
+#include <cstring>
+#include <cassert>
+
+extern unsigned int countOperations;
+
+typedef void (*Merge2Fn)(const int *a, int na, const int *b, int nb, int *out);
+
+// i such that a[0..i) and b[0..r-i) are the r smallest keys of a and b
+int merge2_corank(const int *a, int na, const int *b, int nb, int r) {
+	int lo = r - nb > 0 ? r - nb : 0;
+	int hi = r < na ? r : na;
+
+	// smallest i with a[i] >= b[r-i-1]
+	while (lo < hi) {
+		int i = lo + (hi - lo) / 2;
+
+		if (a[i] < b[r-i-1])
+			lo = i + 1;
+		else
+			hi = i;
+	}
+
+	return lo;
+}
+
+// ties take a first
+static void merge2_tail(const int *a, int i, int na, const int *b, int j, int nb, int *out) {
+	while (i < na && j < nb) {
+		int x = a[i], y = b[j];
+		int takeB = y < x;
+
+		*out++ = takeB ? y : x;
+		i += !takeB;
+		j += takeB;
+	}
+
+	memcpy(out, a + i, (na - i) * sizeof(int));
+	memcpy(out + (na - i), b + j, (nb - j) * sizeof(int));
+}
+
+void merge2_scalar(const int *a, int na, const int *b, int nb, int *out) {
+	merge2_tail(a, 0, na, b, 0, nb, out);
+	countOperations += 2 * (na + nb);
+}
+
+// o keys are stored, the rest of a and b still has to be merged
+static void merge2_finish(const int *a, int na, const int *b, int nb, int *out, int o) {
+	int i = merge2_corank(a, na, b, nb, o);
+
+	merge2_tail(a, i, na, b, o - i, nb, out + o);
+	countOperations += 2 * (na + nb);
+}
+
+#ifdef CPU_X86
+
+// sorts a bitonic vector of 8 keys
+__attribute__((target("avx2")))
+static inline __m256i bitonic_clean8(__m256i v) {
+	__m256i t = _mm256_permute2x128_si256(v, v, 1);
+	v = _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t), 0xF0);
+
+	t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	v = _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t), 0xCC);
+
+	t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t), 0xAA);
+}
+
+// lo, hi: two sorted vectors in, the lower and upper 8 of their 16 keys out
+__attribute__((target("avx2")))
+static inline void bitonic_merge8(__m256i *lo, __m256i *hi) {
+	__m256i rev = _mm256_permutevar8x32_epi32(*hi, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+	*hi = bitonic_clean8(_mm256_max_epi32(*lo, rev));
+	*lo = bitonic_clean8(_mm256_min_epi32(*lo, rev));
+}
+
+__attribute__((target("avx2")))
+void merge2_avx2(const int *a, int na, const int *b, int nb, int *out) {
+	if (na < 8 || nb < 8) {
+		merge2_scalar(a, na, b, nb, out);
+		return;
+	}
+
+	__m256i lo = _mm256_loadu_si256((__m256i*) a);
+	__m256i hi = _mm256_loadu_si256((__m256i*) b);
+	int i = 8, j = 8, o = 0;
+
+	bitonic_merge8(&lo, &hi);
+	_mm256_storeu_si256((__m256i*) out, lo);
+	o += 8;
+
+	while (i + 8 <= na && j + 8 <= nb) {
+		if (a[i] < b[j]) {
+			lo = _mm256_loadu_si256((__m256i*) (a + i));
+			i += 8;
+		} else {
+			lo = _mm256_loadu_si256((__m256i*) (b + j));
+			j += 8;
+		}
+
+		bitonic_merge8(&lo, &hi);
+		_mm256_storeu_si256((__m256i*) (out + o), lo);
+		o += 8;
+	}
+
+	merge2_finish(a, na, b, nb, out, o);
+}
+
+/*	the AVX-512 kernels use the zero-masking forms with a full mask: GCC 12
+	builds the plain permutexvar/min/max on an undefined pass-through
+	vector and warns about it (-Wmaybe-uninitialized); the code is the same
+*/
+#define SIMD_ALL16 ((__mmask16) 0xFFFF)
+
+// sorts a bitonic vector of 16 keys
+__attribute__((target("avx512f")))
+static inline __m512i bitonic_clean16(__m512i v) {
+	const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const __mmask16 upper[] = { 0xFF00, 0xF0F0, 0xCCCC, 0xAAAA };
+
+	for (int s=0, d=8; s < 4; s++, d /= 2) {
+		__m512i t = _mm512_maskz_permutexvar_epi32(SIMD_ALL16, _mm512_xor_si512(lane, _mm512_set1_epi32(d)), v);
+		v = _mm512_mask_blend_epi32(upper[s], _mm512_maskz_min_epi32(SIMD_ALL16, v, t),
+			_mm512_maskz_max_epi32(SIMD_ALL16, v, t));
+	}
+
+	return v;
+}
+
+__attribute__((target("avx512f")))
+static inline void bitonic_merge16(__m512i *lo, __m512i *hi) {
+	__m512i rev = _mm512_maskz_permutexvar_epi32(SIMD_ALL16,
+		_mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), *hi);
+
+	*hi = bitonic_clean16(_mm512_maskz_max_epi32(SIMD_ALL16, *lo, rev));
+	*lo = bitonic_clean16(_mm512_maskz_min_epi32(SIMD_ALL16, *lo, rev));
+}
+
+__attribute__((target("avx512f")))
+void merge2_avx512(const int *a, int na, const int *b, int nb, int *out) {
+	if (na < 16 || nb < 16) {
+		merge2_scalar(a, na, b, nb, out);
+		return;
+	}
+
+	__m512i lo = _mm512_loadu_si512(a);
+	__m512i hi = _mm512_loadu_si512(b);
+	int i = 16, j = 16, o = 0;
+
+	bitonic_merge16(&lo, &hi);
+	_mm512_storeu_si512(out, lo);
+	o += 16;
+
+	while (i + 16 <= na && j + 16 <= nb) {
+		if (a[i] < b[j]) {
+			lo = _mm512_loadu_si512(a + i);
+			i += 16;
+		} else {
+			lo = _mm512_loadu_si512(b + j);
+			j += 16;
+		}
+
+		bitonic_merge16(&lo, &hi);
+		_mm512_storeu_si512(out + o, lo);
+		o += 16;
+	}
+
+	merge2_finish(a, na, b, nb, out, o);
+}
+
+#endif
+
+Merge2Fn select_merge2() {
+#ifdef CPU_X86
+	if (cpuSimdLevel() >= SIMD_AVX512)
+		return merge2_avx512;
+
+	if (cpuSimdLevel() >= SIMD_AVX2)
+		return merge2_avx2;
+#endif
+	return merge2_scalar;
+}
+
+static Merge2Fn merge2_simd = select_merge2();
+
+#endif
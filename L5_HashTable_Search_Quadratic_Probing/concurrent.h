@@ -0,0 +1,88 @@
+/*	Concurrent open-addressing set of ids, safe for many threads at once.
+
+	- one std::atomic<unsigned int> per slot, 0 marks an empty slot
+	- insert claims an empty slot with a compare-and-swap 0 -> id; when
+	  the CAS loses, the winner's id is read back: if it is the same id
+	  the insert is a duplicate, otherwise probing goes on; a claimed
+	  slot never changes again, so no locks are needed
+	- lookups are plain acquire loads along the same probe sequence and
+	  never wait for writers (lock-free, in fact wait-free)
+	- linear probing over a power of two table with the murmur mixer
+	  (hashfns.h), no erase and no resize, so the capacity must cover
+	  every insert; countOperations is not touched (it is not atomic)
+
+	compile with -pthread
+*/
+
+#ifndef CONCURRENT_H
+#define CONCURRENT_H
+
+#include "hashfns.h"
+#include <atomic>
+#include <cstdlib>
+#include <cassert>
+
+typedef struct {
+	int mask;		// slots - 1
+	std::atomic<unsigned int> *keys;
+} ConcurrentTable;
+
+// at least minSlots slots, rounded up to a power of two
+ConcurrentTable *createConcurrentTable(int minSlots) {
+	ConcurrentTable *T = (ConcurrentTable*) malloc(sizeof(ConcurrentTable));
+	assert(T != NULL);
+
+	int slots = 1;
+	while (slots < minSlots)
+		slots *= 2;
+
+	T->mask = slots - 1;
+	T->keys = new std::atomic<unsigned int>[slots];
+	for (int i=0; i < slots; i++)
+		T->keys[i].store(0, std::memory_order_relaxed);
+
+	return T;
+}
+
+void freeConcurrentTable(ConcurrentTable *T) {
+	delete[] T->keys;
+	free(T);
+}
+
+// false if id was already there or the table is full
+bool concurrentInsert(ConcurrentTable *T, unsigned int id) {
+	assert(id != 0);
+	unsigned int pos = hashMurmur(id) & T->mask;
+
+	for (int i=0; i <= T->mask; i++, pos = (pos + 1) & T->mask) {
+		unsigned int cur = T->keys[pos].load(std::memory_order_acquire);
+
+		if (cur == 0) {
+			if (T->keys[pos].compare_exchange_strong(cur, id, std::memory_order_acq_rel))
+				return true;
+			// lost the race, cur now holds the winner's id
+		}
+
+		if (cur == id)
+			return false;
+	}
+
+	return false;
+}
+
+bool concurrentFind(ConcurrentTable *T, unsigned int id) {
+	unsigned int pos = hashMurmur(id) & T->mask;
+
+	for (int i=0; i <= T->mask; i++, pos = (pos + 1) & T->mask) {
+		unsigned int cur = T->keys[pos].load(std::memory_order_acquire);
+
+		if (cur == id)
+			return true;
+		if (cur == 0)
+			return false;
+	}
+
+	return false;
+}
+
+#endif
@@ -0,0 +1,230 @@
+/*	Bucketized cuckoo hashing: 2 hash functions, 4 slots per bucket.
+
+	- an id can only be in one of its two buckets (hashMurmur and
+	  hashWyhash from hashfns.h) or in the small stash, so a lookup
+	  compares at most 8 ids in 2 buckets; a bucket is 16 aligned bytes,
+	  so it never straddles a cache line: at most two lines per lookup
+	- an insert into two full buckets searches breadth first for the
+	  shortest chain of moves that ends in a bucket with a free slot
+	  (every key can move to its other bucket), then shifts the keys
+	  along the chain back to front so that every key stays findable
+	- when the search gives up after CUCKOO_BFS_MAX buckets the id goes
+	  to the stash of CUCKOO_STASH slots, which every lookup scans last;
+	  only a full stash makes the insert fail
+
+	countOperations: one per id compared
+*/
+
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include "hashfns.h"
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+#define CUCKOO_SLOTS 4
+#define CUCKOO_STASH 8
+#define CUCKOO_BFS_MAX 512
+
+extern unsigned int countOperations;
+
+typedef struct {
+	unsigned int keys[CUCKOO_SLOTS];
+} __attribute__((aligned(16))) CuckooBucket;
+
+// id 0 marks an empty slot
+typedef struct {
+	int buckets;
+	CuckooBucket *table;
+	char **names;		// names[b * CUCKOO_SLOTS + s] belongs to table[b].keys[s]
+	unsigned int stash[CUCKOO_STASH];
+	char *stashNames[CUCKOO_STASH];
+	int stashLen;
+} CuckooTable;
+
+CuckooTable *createCuckooTable(int m) {
+	CuckooTable *T = (CuckooTable*) malloc(sizeof(CuckooTable));
+	assert(T != NULL);
+
+	T->buckets = (m + CUCKOO_SLOTS - 1) / CUCKOO_SLOTS;
+	if (T->buckets < 2)
+		T->buckets = 2;
+
+	T->table = (CuckooBucket*) aligned_alloc(sizeof(CuckooBucket), T->buckets * sizeof(CuckooBucket));
+	T->names = (char**) calloc(T->buckets * CUCKOO_SLOTS, sizeof(char*));
+	assert(T->table != NULL && T->names != NULL);
+	memset(T->table, 0, T->buckets * sizeof(CuckooBucket));
+	T->stashLen = 0;
+
+	return T;
+}
+
+void emptyCuckooTable(CuckooTable *T) {
+	for (int i=0; i < T->buckets * CUCKOO_SLOTS; i++)
+		free(T->names[i]);
+	for (int i=0; i < T->stashLen; i++)
+		free(T->stashNames[i]);
+
+	memset(T->table, 0, T->buckets * sizeof(CuckooBucket));
+	memset(T->names, 0, T->buckets * CUCKOO_SLOTS * sizeof(char*));
+	T->stashLen = 0;
+}
+
+void freeCuckooTable(CuckooTable *T) {
+	emptyCuckooTable(T);
+	free(T->table);
+	free(T->names);
+	free(T);
+}
+
+static inline int cuckooBucket1(CuckooTable *T, unsigned int id) {
+	return hashMurmur(id) % T->buckets;
+}
+
+static inline int cuckooBucket2(CuckooTable *T, unsigned int id) {
+	int b1 = cuckooBucket1(T, id), b2 = hashWyhash(id) % T->buckets;
+	return b2 != b1 ? b2 : (b1 + 1) % T->buckets;
+}
+
+// the bucket id is not in right now
+static inline int cuckooOther(CuckooTable *T, unsigned int id, int b) {
+	int b1 = cuckooBucket1(T, id);
+	return b == b1 ? cuckooBucket2(T, id) : b1;
+}
+
+static inline int cuckooFreeSlot(CuckooTable *T, int b) {
+	for (int s=0; s < CUCKOO_SLOTS; s++)
+		if (T->table[b].keys[s] == 0)
+			return s;
+
+	return -1;
+}
+
+static inline void cuckooPut(CuckooTable *T, int b, int s, unsigned int id, char *name) {
+	T->table[b].keys[s] = id;
+	T->names[b * CUCKOO_SLOTS + s] = name;
+}
+
+/*	breadth first search from the two buckets of id for a bucket with a
+	free slot; on success shifts the keys along the path and returns the
+	(bucket, slot) freed at the start of it in *b, *s
+*/
+static bool cuckooMakeRoom(CuckooTable *T, unsigned int id, int *b, int *s) {
+	// node i: bucket[i], reached by moving the key in slot[i] of bucket[parent[i]]
+	int bucket[CUCKOO_BFS_MAX], parent[CUCKOO_BFS_MAX], slot[CUCKOO_BFS_MAX];
+	int len = 2, found = -1, freeSlot = -1;
+
+	bucket[0] = cuckooBucket1(T, id);
+	bucket[1] = cuckooBucket2(T, id);
+	parent[0] = parent[1] = -1;
+
+	for (int head=0; head < len && found < 0; head++) {
+		for (int k=0; k < CUCKOO_SLOTS && len < CUCKOO_BFS_MAX; k++) {
+			unsigned int key = T->table[bucket[head]].keys[k];
+			int alt = cuckooOther(T, key, bucket[head]);
+
+			bucket[len] = alt;
+			parent[len] = head;
+			slot[len] = k;
+			len++;
+
+			int fs = cuckooFreeSlot(T, alt);
+			if (fs >= 0) {
+				found = len - 1;
+				freeSlot = fs;
+				break;
+			}
+		}
+	}
+
+	if (found < 0)
+		return false;
+
+	// back to front: every key moves into the slot freed just before
+	int node = found;
+	for (; parent[node] >= 0; node = parent[node]) {
+		int from = bucket[parent[node]], k = slot[node];
+
+		cuckooPut(T, bucket[node], freeSlot, T->table[from].keys[k], T->names[from * CUCKOO_SLOTS + k]);
+		freeSlot = k;
+	}
+
+	*b = bucket[node];
+	*s = freeSlot;
+	return true;
+}
+
+// the name is copied, like createEntry does; false if even the stash is full
+bool cuckooInsert(CuckooTable *T, unsigned int id, char *name = NULL) {
+	assert(id != 0);
+	char *copy = NULL;
+	int b, s;
+
+	if (name) {
+		copy = (char*) malloc(strlen(name) + 1);
+		strcpy(copy, name);
+	}
+
+	b = cuckooBucket1(T, id);
+	s = cuckooFreeSlot(T, b);
+	if (s < 0) {
+		b = cuckooBucket2(T, id);
+		s = cuckooFreeSlot(T, b);
+	}
+
+	if (s >= 0 || cuckooMakeRoom(T, id, &b, &s)) {
+		cuckooPut(T, b, s, id, copy);
+		return true;
+	}
+
+	if (T->stashLen < CUCKOO_STASH) {
+		T->stash[T->stashLen] = id;
+		T->stashNames[T->stashLen++] = copy;
+		return true;
+	}
+
+	free(copy);
+	return false;
+}
+
+static inline int cuckooScan(CuckooTable *T, int b, unsigned int id) {
+	for (int s=0; s < CUCKOO_SLOTS; s++) {
+		if (T->table[b].keys[s] == 0)
+			continue;
+
+		countOperations++;
+		if (T->table[b].keys[s] == id)	// cmp++
+			return s;
+	}
+
+	return -1;
+}
+
+// no allocation: the name (may be NULL) goes to *name if it is not NULL
+bool cuckooFind(CuckooTable *T, unsigned int id, char **name = NULL) {
+	int b[2] = { cuckooBucket1(T, id), cuckooBucket2(T, id) };
+
+	for (int i=0; i < 2; i++) {
+		int s = cuckooScan(T, b[i], id);
+
+		if (s >= 0) {
+			if (name)
+				*name = T->names[b[i] * CUCKOO_SLOTS + s];
+			return true;
+		}
+	}
+
+	for (int i=0; i < T->stashLen; i++) {
+		countOperations++;
+		if (T->stash[i] == id) {	// cmp++
+			if (name)
+				*name = T->stashNames[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#endif
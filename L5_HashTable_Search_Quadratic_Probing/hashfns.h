@@ -0,0 +1,72 @@
+/*	Hash functions for integer ids, all with the same signature so the
+	tables can switch between them (hashFn in the lab file).
+
+	- identity: the original hash_, ids that are equal mod m collide
+	- multiply-shift: high half of a*x + b with random 64 bit a (odd)
+	  and b, a universal family (Dietzfelbinger)
+	- fibonacci: multiply-shift with the fixed a = 2^64 / golden ratio
+	- murmur: the fmix32 finalizer of MurmurHash3
+	- wyhash: wyhash's mum mixer, 64x64 -> 128 bit multiply of the id
+	  xor two secrets, folded by xor of the two halves
+	- tabulation: xor of 4 random tables indexed by the id's bytes,
+	  3-independent
+
+	hashFnsSeed() draws the random parameters from common/rng.h
+*/
+
+#ifndef HASHFNS_H
+#define HASHFNS_H
+
+#include "../common/rng.h"
+#include <stdint.h>
+
+typedef unsigned int (*HashFn)(unsigned int key);
+
+static uint64_t msA = 0x9E3779B97F4A7C15ull, msB = 0;
+static uint64_t wySecret[2] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull };
+static unsigned int tabTable[4][256];
+
+void hashFnsSeed() {
+	msA = rngNext64() | 1;
+	msB = rngNext64();
+	wySecret[0] = rngNext64();
+	wySecret[1] = rngNext64();
+
+	for (int t=0; t < 4; t++)
+		for (int b=0; b < 256; b++)
+			tabTable[t][b] = rngNext32();
+}
+
+unsigned int hashIdentity(unsigned int key) {
+	return key;
+}
+
+unsigned int hashMultiplyShift(unsigned int key) {
+	return (unsigned int) ((msA * key + msB) >> 32);
+}
+
+unsigned int hashFibonacci(unsigned int key) {
+	return (unsigned int) ((0x9E3779B97F4A7C15ull * key) >> 32);
+}
+
+unsigned int hashMurmur(unsigned int key) {
+	key ^= key >> 16;
+	key *= 0x85ebca6b;
+	key ^= key >> 13;
+	key *= 0xc2b2ae35;
+	key ^= key >> 16;
+	return key;
+}
+
+unsigned int hashWyhash(unsigned int key) {
+	__uint128_t r = (__uint128_t) (key ^ wySecret[0]) * (key ^ wySecret[1]);
+	uint64_t folded = (uint64_t) r ^ (uint64_t) (r >> 64);
+	return (unsigned int) (folded ^ (folded >> 32));
+}
+
+unsigned int hashTabulation(unsigned int key) {
+	return tabTable[0][key & 0xff] ^ tabTable[1][(key >> 8) & 0xff]
+		^ tabTable[2][(key >> 16) & 0xff] ^ tabTable[3][key >> 24];
+}
+
+#endif
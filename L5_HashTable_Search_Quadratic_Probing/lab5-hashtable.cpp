@@ -1,5 +1,5 @@
 /*	NOTE:
-		- i used a uniform random function drand48()
+		- i used the shared xoshiro256++ generator (common/rng.h)
 		- last resulting table:
 		------------------------------------------------------------------
 		|FF  |  AvgFound|  AvgNotFound  |      MaxFound |       MaxNotF |
@@ -18,20 +18,82 @@
 	OBSERVATIONS:
 		- in all cases there was a large jump from
 		  alpha=0.95 to alpha=0.99
+		- FlatTable uses the same probe sequence, so the effort columns
+		  are the same; it keeps the keys inline in one array and the
+		  names in a parallel one, so a probe reads one int instead of
+		  following an Entry*, and flatFind allocates nothing; the
+		  ns/find column of averageSearch shows the difference
+		- SwissTable (swisstable.h) checks 16 control bytes per probe with
+		  one SSE2 compare, so its effort is groups scanned + ids compared:
+		  at 0.99 an absent key costs ~18 instead of ~96 and the worst
+		  case ~105 instead of ~750, because only a group without an
+		  empty slot sends the search further
+		- RobinTable (robinhood.h) probes linearly but keeps every key's
+		  distance from home: inserts evict keys that are closer to home,
+		  absent keys stop as soon as they would have evicted someone, and
+		  erase shifts the cluster back instead of leaving tombstones;
+		  linear clusters raise the average (~33 at 0.99) but the tail is
+		  much shorter: MaxFound ~90 and MaxNotF ~65 instead of ~225/~750
+		- GrowTable starts small and, when an insert would pass GROW_LOAD,
+		  opens a FlatTable of the next prime >= 2m; the old slots are
+		  moved GROW_MIGRATE at a time on every later insert instead of all
+		  at once, and finds look in both tables meanwhile; once the move
+		  is done the next table is allocated uninitialized and zeroed
+		  GROW_ZERO slots per insert, and the old one is freed without
+		  clearing it, so no single insert touches O(m) memory;
+		  GROW_LOAD = 0.5 because quadratic probing in a prime table always
+		  finds a free slot below that; grow_test() reports p50/p99/p999
+		  insert latency against rehashing everything in one insert
+		- hash_ calls the pluggable hashFn (hashfns.h) and hashKey the
+		  pluggable probeFn (linear, quadratic with a_ct/b_ct, double
+		  hashing); after the averageSearch tables, main runs
+		  hashComparison(): every pair on the flat table with uniform,
+		  sequential and adversarial ids (all equal mod tableSize):
+		  identity hashing turns the adversarial set into one cluster, and
+		  quadratic probing from a single home slot reaches only half of a
+		  prime table, so those inserts fail ("full")
+		- ConcurrentTable (concurrent.h) claims slots with a CAS on the key
+		  and looks up with plain atomic loads, so readers never block;
+		  concurrent_test() reports Mops/s for 95/5 and 50/50 find/insert
+		  mixes from 1 to 64 threads (compile with -pthread)
+		- flatFindBatch looks up a whole array of ids in groups of
+		  BATCH_GROUP: the next group is hashed once and its home slots
+		  prefetched while the current group is probed from its stored
+		  hashes, so the cache misses of a group overlap instead of
+		  stalling one after another; batch_test() compares it with one
+		  flatFind per id (both warmed up once), the gain shows once the
+		  keys array no longer fits in the last level cache
+		- CuckooTable (cuckoo.h) puts every id in one of 2 buckets of 4
+		  slots, moving other keys along the shortest BFS path when both
+		  are full and into a small stash when that fails, so a lookup
+		  compares at most 8 ids (+ the stash): the max columns stay
+		  single digit up to 0.95; at 0.99 the 2x4 layout is past its
+		  load limit and the stash runs out ("full")
 
 	INTERPRETATION:
 
 */
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
+#include "hashfns.h"
+#include "swisstable.h"
+#include "robinhood.h"
+#include "concurrent.h"
+#include "cuckoo.h"
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <climits>
 #include <cassert>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #define AVG_CASE_TRIALS 50
+#define HASH_CASE_TRIALS 5
 #define DIM_MIN 100
 #define DIM_MAX 10000
 #define STEP_SIZE 100
@@ -40,10 +102,29 @@
 
 #define VERBOSE_DEBUG false
 
+#define GROW_LOAD 0.5
+#define GROW_MIGRATE 8		// old slots moved per insert
+#define GROW_ZERO 32		// slots of the next table zeroed per insert
+#define GROW_TEST_N (1 << 20)
+#define CONC_TEST_SLOTS (1 << 22)
+#define CONC_TEST_PREFILL (1 << 20)
+#define CONC_TEST_OPS (1 << 22)		// split between the threads
+#define BATCH_GROUP 16
+#define BATCH_TEST_MAX_SLOTS (1 << 26)	// 256 MB of keys
+#define BATCH_TEST_LOOKUPS (1 << 22)
+
 unsigned int countOperations = 0;
 unsigned int tableSize = 10007;
 int a_ct=0, b_ct=1;
 
+float fillFactor[] = { 0.8, 0.85, 0.9, 0.95, 0.99 };
+#define FF_CASES ((int) (sizeof(fillFactor) / sizeof(fillFactor[0])))
+
+// key sets of averageSearch / hashComparison
+#define KEYS_UNIFORM 0
+#define KEYS_SEQUENTIAL 1
+#define KEYS_ADVERSARIAL 2
+
 typedef struct {
 	unsigned int id;
 	char *name;
@@ -54,22 +135,79 @@ typedef struct {
 	Entry **table;
 } HashTable;
 
-unsigned int getRandom(int max) {
-	double d = drand48();  // gives you a double from 0 to 1
-	double val = d * max;	  // gives you a double from 0 to max
+// id 0 marks an empty slot, like get() does for Entry
+typedef struct {
+	int m;
+	unsigned int *keys;
+	char **names;		// names[i] belongs to keys[i]
+	bool named;		// some name was stored, emptyFlatTable must free names[]
+} FlatTable;
+
+typedef struct {
+	FlatTable *cur;		// inserts go here
+	FlatTable *old;		// being moved into cur, NULL if no resize runs
+	int oldPos;			// old slots before oldPos are moved
+	FlatTable *next;	// cur's successor, allocated early, NULL if none yet
+	int nextPos;		// next slots before nextPos are zeroed
+	int size;
+	int migrate;		// old slots moved per insert, 0 = all at once
+} GrowTable;
 
-	return (unsigned int) round(val);
+// one table implementation as seen by averageSearch
+typedef struct {
+	const char *name;
+	void* (*create)(int m);
+	bool (*insert)(void *T, unsigned int id);	// false if no free slot was found
+	bool (*find)(void *T, unsigned int id);
+	void (*empty)(void *T);
+	void (*destroy)(void *T);
+} TableOps;
+
+typedef struct {
+	float avgFound, avgNotFound;
+	float maxFound, maxNotFound;
+	double nsPerFind;
+	bool full;		// some insert found no free slot
+} SearchStats;
+
+// slot probed i-th for id, whose hash_ is h, in a table of m slots
+typedef unsigned int (*ProbeFn)(unsigned int h, unsigned int id, int i, int m);
+
+// uniform in [0, max]
+unsigned int getRandom(int max) {
+	return rngBounded(max + 1);
 }
 
 
+HashFn hashFn = hashIdentity;
+
 unsigned int hash_(unsigned int key) {
-	return key;
+	return hashFn(key);
 }
 
-unsigned int hash(Entry* k, int i) {
+unsigned int probeLinear(unsigned int h, unsigned int, int i, int m) {
+	return ((uint64_t) h + i) % m;
+}
+
+unsigned int probeQuadratic(unsigned int h, unsigned int, int i, int m) {
+	int64_t j = ((int64_t) h + (int64_t) i*a_ct + (int64_t) i*i*b_ct) % m;
+	return j < 0 ? j + m : j;
+}
+
+// the step comes from a second, independent hash and is never 0 mod m
+unsigned int probeDouble(unsigned int h, unsigned int id, int i, int m) {
+	uint64_t step = m > 1 ? 1 + hashMurmur(id ^ 0x5bd1e995) % (m - 1) : 1;
+	return ((uint64_t) h + i * step) % m;
+}
+
+ProbeFn probeFn = probeQuadratic;
 
-	return hash_(k->id) + i*a_ct + i*i*b_ct;
+unsigned int hashKey(unsigned int id, int i, int m) {
+	return probeFn(hash_(id), id, i, m);
+}
 
+unsigned int hash(Entry* k, int i, int m) {
+	return hashKey(k->id, i, m);
 }
 
 Entry *createEntry(unsigned int id, char *name = NULL) {
@@ -89,12 +227,27 @@ Entry *createEntry(unsigned int id, char *name = NULL) {
 HashTable *createHashTable(int m) {
 	HashTable *h = (HashTable*) malloc(sizeof(HashTable));
 	h->m = m;
-	h->table = (Entry**) calloc(m, sizeof(Entry));
+	h->table = (Entry**) calloc(m, sizeof(Entry*));
+	assert(h->table != NULL);
 
+	return h;
 }
 
+// frees the entries too
 void emptyHashTable(HashTable* T) {
-	memset(T->table, 0, T->m * sizeof(Entry));
+	for (int i=0; i < T->m; i++)
+		if (T->table[i] != NULL) {
+			free(T->table[i]->name);
+			free(T->table[i]);
+		}
+
+	memset(T->table, 0, T->m * sizeof(Entry*));
+}
+
+void freeHashTable(HashTable *T) {
+	emptyHashTable(T);
+	free(T->table);
+	free(T);
 }
 
 Entry* get(HashTable *T, int i) {
@@ -121,7 +274,7 @@ void hashInsert(HashTable *T, Entry* k) {
 	int i, m = T->m, j;
 
 	for (i=0; i < m; i++) {
-		j = hash(k, i) % m;
+		j = hash(k, i, m);
 
 		if (get(T, j) == NULL) {
 			put(T, j, k);
@@ -133,28 +286,338 @@ void hashInsert(HashTable *T, Entry* k) {
 	assert(i < m);
 }
 
-int hashSearch(HashTable *T, Entry* k) {
+int hashSearchId(HashTable *T, unsigned int id) {
 	int i, m = T->m, j;
 
 	for (i=0; i < m; i++) {
-		j = hash(k, i) % m;
+		j = hashKey(id, i, m);
 
 		if (get(T, j) == NULL)
 			break;
 
 		countOperations++;
-		if (T->table[j]->id == k->id)	// cmp++
+		if (T->table[j]->id == id)	// cmp++
 			return j;
 	}
 
 	return -1;
 }
 
+int hashSearch(HashTable *T, Entry* k) {
+	return hashSearchId(T, k->id);
+}
+
 Entry* hashFind(HashTable* T, int id) {
-	Entry *tmp = createEntry(id);
-	return get(T, hashSearch(T, tmp));
+	return get(T, hashSearchId(T, id));
+}
+
+FlatTable *createFlatTable(int m) {
+	FlatTable *T = (FlatTable*) malloc(sizeof(FlatTable));
+	assert(T != NULL);
+
+	T->m = m;
+	T->keys = (unsigned int*) calloc(m, sizeof(unsigned int));
+	T->names = (char**) calloc(m, sizeof(char*));
+	assert(T->keys != NULL && T->names != NULL);
+	T->named = false;
+
+	return T;
+}
+
+// keys and names are left uninitialized, the caller zeroes them before use
+static FlatTable *allocFlatTable(int m) {
+	FlatTable *T = (FlatTable*) malloc(sizeof(FlatTable));
+	assert(T != NULL);
+
+	T->m = m;
+	T->keys = (unsigned int*) malloc(m * sizeof(unsigned int));
+	T->names = (char**) malloc(m * sizeof(char*));
+	assert(T->keys != NULL && T->names != NULL);
+	T->named = false;
+
+	return T;
+}
+
+// O(m) over names[] only if a name was ever stored
+void emptyFlatTable(FlatTable *T) {
+	if (T->named) {
+		for (int i=0; i < T->m; i++)
+			free(T->names[i]);
+
+		memset(T->names, 0, T->m * sizeof(char*));
+		T->named = false;
+	}
+
+	memset(T->keys, 0, T->m * sizeof(unsigned int));
+}
+
+// no clearing before the free, names[] is only walked if a name was stored
+void freeFlatTable(FlatTable *T) {
+	if (T->named)
+		for (int i=0; i < T->m; i++)
+			free(T->names[i]);
+
+	free(T->keys);
+	free(T->names);
+	free(T);
+}
+
+// first free slot on the probe sequence of id, -1 if m probes found none
+static int flatFreeSlot(FlatTable *T, unsigned int id) {
+	int m = T->m;
+
+	for (int i=0; i < m; i++) {
+		int j = hashKey(id, i, m);
+
+		if (T->keys[j] == 0)
+			return j;
+	}
+
+	return -1;
+}
+
+// the name is copied, like createEntry does; false if no free slot was found
+bool flatTryInsert(FlatTable *T, unsigned int id, char *name = NULL) {
+	assert(id != 0);
+	int j = flatFreeSlot(T, id);
+
+	if (j < 0)
+		return false;
+
+	T->keys[j] = id;
+	if (name) {
+		T->names[j] = (char*) malloc(strlen(name) + 1);
+		strcpy(T->names[j], name);
+		T->named = true;
+	}
+	return true;
+}
+
+void flatInsert(FlatTable *T, unsigned int id, char *name = NULL) {
+	if (!flatTryInsert(T, id, name)) {
+		printf("\nm=%d, id=%d\n", T->m, id);
+		assert(!"flat table full");
+	}
+}
+
+// index of id or -1; h is hash_(id), so the probe loop never rehashes
+int flatSearchHashed(FlatTable *T, unsigned int id, unsigned int h) {
+	int i, m = T->m, j;
+
+	for (i=0; i < m; i++) {
+		j = probeFn(h, id, i, m);
+
+		if (T->keys[j] == 0)
+			break;
+
+		countOperations++;
+		if (T->keys[j] == id)	// cmp++
+			return j;
+	}
+
+	return -1;
+}
+
+int flatSearch(FlatTable *T, unsigned int id) {
+	return flatSearchHashed(T, id, hash_(id));
+}
+
+// hashes a group of keys once into h[] and prefetches their home slots
+static inline void flatHashGroup(FlatTable *T, const unsigned int *keys, int n, unsigned int *h) {
+	for (int i=0; i < n; i++) {
+		h[i] = hash_(keys[i]);
+		__builtin_prefetch(&T->keys[probeFn(h[i], keys[i], 0, T->m)]);
+	}
+}
+
+// out[i] = flatSearch(T, keys[i]); group g+1 is hashed and prefetched
+// before group g is probed, so its home slots load while g is searched
+void flatFindBatch(FlatTable *T, const unsigned int *keys, int n, int *out) {
+	unsigned int h[2][BATCH_GROUP];
+	int cur = 0;
+
+	flatHashGroup(T, keys, n < BATCH_GROUP ? n : BATCH_GROUP, h[cur]);
+
+	for (int g=0; g < n; g += BATCH_GROUP, cur ^= 1) {
+		int end = g + BATCH_GROUP < n ? g + BATCH_GROUP : n;
+		int next = end + BATCH_GROUP < n ? end + BATCH_GROUP : n;
+
+		flatHashGroup(T, keys + end, next - end, h[cur ^ 1]);
+
+		for (int i=g; i < end; i++)
+			out[i] = flatSearchHashed(T, keys[i], h[cur][i - g]);
+	}
+}
+
+// no allocation: the name (may be NULL) goes to *name if it is not NULL
+bool flatFind(FlatTable *T, unsigned int id, char **name = NULL) {
+	int j = flatSearch(T, id);
+
+	if (j < 0)
+		return false;
+
+	if (name)
+		*name = T->names[j];
+	return true;
+}
+
+bool isPrime(int n) {
+	if (n < 2)
+		return false;
+
+	for (int d=2; d*d <= n; d++)
+		if (n % d == 0)
+			return false;
+
+	return true;
+}
+
+int nextPrime(int n) {
+	while (!isPrime(n))
+		n++;
+
+	return n;
+}
+
+GrowTable *createGrowTable(int m, int migrate = GROW_MIGRATE) {
+	GrowTable *G = (GrowTable*) malloc(sizeof(GrowTable));
+	assert(G != NULL);
+
+	G->cur = createFlatTable(nextPrime(m));
+	G->old = NULL;
+	G->oldPos = 0;
+	G->next = NULL;
+	G->nextPos = 0;
+	G->size = 0;
+	G->migrate = migrate;
+	return G;
+}
+
+void freeGrowTable(GrowTable *G) {
+	if (G->old != NULL)
+		freeFlatTable(G->old);
+	if (G->next != NULL)
+		freeFlatTable(G->next);
+
+	freeFlatTable(G->cur);
+	free(G);
+}
+
+// moves up to count old slots into cur, the name goes along with its key
+static void growMigrate(GrowTable *G, int count) {
+	FlatTable *old = G->old;
+
+	for (; count > 0 && G->oldPos < old->m; count--, G->oldPos++) {
+		int i = G->oldPos;
+		if (old->keys[i] == 0)
+			continue;
+
+		// the key stays in old so its probe chains still work until old is freed
+		int j = flatFreeSlot(G->cur, old->keys[i]);
+		assert(j >= 0);
+		G->cur->keys[j] = old->keys[i];
+		G->cur->names[j] = old->names[i];
+		G->cur->named |= old->names[i] != NULL;
+		old->names[i] = NULL;
+	}
+
+	// every name was moved, so freeFlatTable skips the O(m) names pass
+	if (G->oldPos == old->m) {
+		old->named = false;
+		freeFlatTable(old);
+		G->old = NULL;
+	}
+}
+
+// zeroes up to count more slots of next, allocating it on the first call
+static void growPrepare(GrowTable *G, int count) {
+	if (G->next == NULL) {
+		G->next = allocFlatTable(nextPrime(2 * G->cur->m));
+		G->nextPos = 0;
+	}
+
+	FlatTable *next = G->next;
+	int end = count < next->m - G->nextPos ? G->nextPos + count : next->m;
+
+	memset(next->keys + G->nextPos, 0, (end - G->nextPos) * sizeof(unsigned int));
+	memset(next->names + G->nextPos, 0, (end - G->nextPos) * sizeof(char*));
+	G->nextPos = end;
 }
 
+void growInsert(GrowTable *G, unsigned int id, char *name = NULL) {
+	if (G->old != NULL)
+		growMigrate(G, G->migrate > 0 ? G->migrate : G->old->m);
+	else if (G->migrate > 0)
+		growPrepare(G, GROW_ZERO);
+
+	if (G->size + 1 > GROW_LOAD * G->cur->m) {
+		// a resize that is still running is finished first
+		if (G->old != NULL)
+			growMigrate(G, G->old->m);
+
+		// so is the zeroing of next; all at once allocates it here
+		if (G->next != NULL)
+			growPrepare(G, G->next->m);
+
+		G->old = G->cur;
+		G->oldPos = 0;
+		G->cur = G->next != NULL ? G->next : createFlatTable(nextPrime(2 * G->old->m));
+		G->next = NULL;
+
+		if (G->migrate == 0)
+			growMigrate(G, G->old->m);
+	}
+
+	flatInsert(G->cur, id, name);
+	G->size++;
+}
+
+// no allocation, cur first then whatever is not moved yet
+bool growFind(GrowTable *G, unsigned int id, char **name = NULL) {
+	if (flatFind(G->cur, id, name))
+		return true;
+
+	return G->old != NULL && flatFind(G->old, id, name);
+}
+
+void* entryCreate(int m) { return createHashTable(m); }
+bool entryInsert(void *T, unsigned int id) { hashInsert((HashTable*) T, createEntry(id)); return true; }
+bool entryFind(void *T, unsigned int id) { return hashFind((HashTable*) T, id) != NULL; }
+void entryEmpty(void *T) { emptyHashTable((HashTable*) T); }
+void entryDestroy(void *T) { freeHashTable((HashTable*) T); }
+
+void* flatCreate(int m) { return createFlatTable(m); }
+bool flatInsertId(void *T, unsigned int id) { return flatTryInsert((FlatTable*) T, id); }
+bool flatFindId(void *T, unsigned int id) { return flatFind((FlatTable*) T, id); }
+void flatEmpty(void *T) { emptyFlatTable((FlatTable*) T); }
+void flatDestroy(void *T) { freeFlatTable((FlatTable*) T); }
+
+void* swissCreate(int m) { return createSwissTable(m); }
+bool swissInsertId(void *T, unsigned int id) { swissInsert((SwissTable*) T, id); return true; }
+bool swissFindId(void *T, unsigned int id) { return swissFind((SwissTable*) T, id); }
+void swissEmpty(void *T) { emptySwissTable((SwissTable*) T); }
+void swissDestroy(void *T) { freeSwissTable((SwissTable*) T); }
+
+void* robinCreate(int m) { return createRobinTable(m); }
+bool robinInsertId(void *T, unsigned int id) { robinInsert((RobinTable*) T, id); return true; }
+bool robinFindId(void *T, unsigned int id) { return robinFind((RobinTable*) T, id); }
+void robinEmpty(void *T) { emptyRobinTable((RobinTable*) T); }
+void robinDestroy(void *T) { freeRobinTable((RobinTable*) T); }
+
+void* cuckooCreate(int m) { return createCuckooTable(m); }
+bool cuckooInsertId(void *T, unsigned int id) { return cuckooInsert((CuckooTable*) T, id); }
+bool cuckooFindId(void *T, unsigned int id) { return cuckooFind((CuckooTable*) T, id); }
+void cuckooEmpty(void *T) { emptyCuckooTable((CuckooTable*) T); }
+void cuckooDestroy(void *T) { freeCuckooTable((CuckooTable*) T); }
+
+TableOps tables[] = {
+	{ "Entry* table", entryCreate, entryInsert, entryFind, entryEmpty, entryDestroy },
+	{ "flat table", flatCreate, flatInsertId, flatFindId, flatEmpty, flatDestroy },
+	{ "swiss table", swissCreate, swissInsertId, swissFindId, swissEmpty, swissDestroy },
+	{ "robin hood table", robinCreate, robinInsertId, robinFindId, robinEmpty, robinDestroy },
+	{ "cuckoo table", cuckooCreate, cuckooInsertId, cuckooFindId, cuckooEmpty, cuckooDestroy },
+};
+
 void demo() {
 	HashTable* T = createHashTable(10);
 	hashInsert(T, createEntry(1, "fall"));
@@ -188,67 +651,145 @@ void demo() {
 		printf("Couldn't find any entry with id=6\n");
 	else
 		printf("Found entry with id=%d, name=%s, index=%d\n", eFound->id, eFound->name, hashSearch(T, eFound));
+
+	freeHashTable(T);
+
+	FlatTable *F = createFlatTable(10);
+	flatInsert(F, 1, "fall");
+	flatInsert(F, 7, "after");
+	flatInsert(F, 2, "leaves");
+
+	char *name;
+	if (flatFind(F, 7, &name))
+		printf("Flat table: id=7, name=%s, index=%d\n", name, flatSearch(F, 7));
+	if (!flatFind(F, 6))
+		printf("Flat table: no entry with id=6\n");
+
+	freeFlatTable(F);
+
+	SwissTable *S = createSwissTable(10);
+	swissInsert(S, 1, "fall");
+	swissInsert(S, 7, "after");
+	swissInsert(S, 2, "leaves");
+	swissErase(S, 1);
+
+	if (swissFind(S, 7, &name))
+		printf("Swiss table: id=7, name=%s, slot=%d\n", name, swissSearch(S, 7));
+	if (!swissFind(S, 1))
+		printf("Swiss table: id=1 was erased\n");
+
+	freeSwissTable(S);
+
+	RobinTable *R = createRobinTable(10);
+	robinInsert(R, 1, "fall");
+	robinInsert(R, 11, "leaves");
+	robinInsert(R, 2, "after");
+	robinErase(R, 1);
+
+	if (robinFind(R, 11, &name))
+		printf("Robin hood table: id=11, name=%s, slot=%d\n", name, robinSearch(R, 11));
+	if (!robinFind(R, 1))
+		printf("Robin hood table: id=1 was erased\n");
+
+	freeRobinTable(R);
+
+	CuckooTable *C = createCuckooTable(8);
+	for (unsigned int id=1; id <= 8; id++)
+		cuckooInsert(C, id, id == 5 ? (char*) "cuckoo" : NULL);
+
+	if (cuckooFind(C, 5, &name))
+		printf("Cuckoo table: 8 ids in %d buckets + %d stashed, id=5, name=%s\n", C->buckets, C->stashLen, name);
+
+	freeCuckooTable(C);
+
+	GrowTable *G = createGrowTable(2);
+	for (unsigned int id=1; id <= 100; id++)
+		growInsert(G, id, id == 42 ? (char*) "answer" : NULL);
+
+	if (growFind(G, 42, &name))
+		printf("Growing table: 100 ids in %d slots, id=42, name=%s\n", G->cur->m, name);
+
+	freeGrowTable(G);
 }
 
-void averageSearch() {
-	srand48(time(NULL));
-	float fillFactor[] = { 0.8, 0.85, 0.9, 0.95, 0.99 };
-	int cases = sizeof(fillFactor) / sizeof(int);
-	float avgEffortFound[cases];
-	float maxEffortFound[cases];
-	float avgEffortNotFound[cases];
-	float maxEffortNotFound[cases];
-
-	for (int a=0; a < cases; a++) {
-		avgEffortFound[a] = 0;
-		avgEffortNotFound[a] = 0;
-		maxEffortFound[a] = 0;
-		maxEffortNotFound[a] = 0;
+// the keys put in the table and the keys searched: first half absent, second half present
+void makeKeys(int keySet, int *arr, int arrSize, int *searchArr, int m) {
+	int k = 0;
+
+	if (keySet == KEYS_UNIFORM) {
+		rngFillArray(arr, arrSize, RANGE_MIN, RANGE_MAX, false, UNSORTED);
+
+		char *countApparition = (char*) calloc(RANGE_MAX + 1, sizeof(char));
+		for (int j=0; j < arrSize; j++)
+			countApparition[arr[j]]++;
+
+		for (int j=RANGE_MIN; j <= RANGE_MAX; j++) {
+			if (countApparition[j] == (char) 0)
+				searchArr[k++] = j;
+
+			if (k > m/2)
+				break;
+		}
+
+		free(countApparition);
+	} else {
+		// sequential ids, or ids that are all equal mod tableSize
+		int stride = keySet == KEYS_SEQUENTIAL ? 1 : tableSize;
+
+		for (int j=0; j < arrSize; j++)
+			arr[j] = RANGE_MIN + j * stride;
+		rngShuffle(arr, arrSize);
+
+		for (; k <= m/2; k++)
+			searchArr[k] = RANGE_MIN + (arrSize + k) * stride;
 	}
 
-	HashTable* T = createHashTable(tableSize);
+	for (; k < m; k++)
+		searchArr[k] = arr[getRandom(arrSize-1)];
+}
 
-	for (int k=0; k < AVG_CASE_TRIALS; k++)
-		for (int a=0; a < cases; a++) {
-			int arrSize = tableSize*fillFactor[a];
-			int m = 3000;		// no. of elements to be searched
+void searchEffort(TableOps *ops, int keySet, int trials, SearchStats *stats) {
+	for (int a=0; a < FF_CASES; a++)
+		memset(&stats[a], 0, sizeof(SearchStats));
 
-			int arr[arrSize];
-			FillRandomArray(arr, arrSize, RANGE_MIN, RANGE_MAX, false, UNSORTED);
+	void* T = ops->create(tableSize);
 
-			char *countApparition = (char*) calloc(RANGE_MAX + 1, sizeof(char));
+	for (int k=0; k < trials; k++)
+		for (int a=0; a < FF_CASES; a++) {
+			int arrSize = tableSize*fillFactor[a];
+			int m = 3000;		// no. of elements to be searched
 
-			for (int j=0; j < arrSize; j++) {
-				hashInsert(T, createEntry(arr[j]));
-				countApparition[arr[j]]++;
-			}
+			if (stats[a].full)
+				continue;
 
-			// generating the search elements
+			int arr[arrSize];
 			int searchArr[m];
-			int k=0;
-			// first half is elements not to be found
-			for (int j=RANGE_MIN; j <= RANGE_MAX; j++) {
-				if (countApparition[j] == (char) 0)
-					searchArr[k++] = j;
-
-				if (k > m/2)
-					break;
-			}
+			makeKeys(keySet, arr, arrSize, searchArr, m);
 
-			// second half is elements to be found
-			for (; k < m; k++) {
-				searchArr[k] = arr[getRandom(arrSize)];
-			}
+			for (int j=0; j < arrSize && !stats[a].full; j++)
+				stats[a].full = !ops->insert(T, arr[j]);
 
+			if (stats[a].full) {
+				ops->empty(T);
+				continue;
+			}
 
 			int found=0, notFound=0;
 			int effortFound=0, effortNotFound=0;
 			int maxFound=0, maxNotFound=0;
 
+			// timed apart from the counting loop, without the bookkeeping
+			auto start = std::chrono::steady_clock::now();
+			int hits = 0;
+			for (int j=0; j < m; j++)
+				hits += ops->find(T, searchArr[j]);
+			stats[a].nsPerFind += std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count() / m;
+			assert(hits > 0);
+
 			for (int j=0; j < m; j++) {
 				countOperations = 0;
-				Entry* e = hashFind(T, searchArr[j]);
-				if (e) {
+				if (ops->find(T, searchArr[j])) {
 					effortFound += countOperations;
 					found++;
 
@@ -263,39 +804,260 @@ void averageSearch() {
 				}
 			}
 
-			avgEffortFound[a] += (double) effortFound / found;
-			avgEffortNotFound[a] += (double) effortNotFound / notFound;
-			maxEffortFound[a] += maxFound;
-			maxEffortNotFound[a] += maxNotFound;
-			emptyHashTable(T);
-			free(countApparition);
+			stats[a].avgFound += (double) effortFound / found;
+			stats[a].avgNotFound += (double) effortNotFound / notFound;
+			stats[a].maxFound += maxFound;
+			stats[a].maxNotFound += maxNotFound;
+			ops->empty(T);
 		}
 
-	for (int a=0; a < cases; a++) {
-		avgEffortFound[a] /= AVG_CASE_TRIALS;
-		avgEffortNotFound[a] /= AVG_CASE_TRIALS;
-		maxEffortFound[a] /= AVG_CASE_TRIALS;
-		maxEffortNotFound[a] /= AVG_CASE_TRIALS;
+	ops->destroy(T);
+
+	for (int a=0; a < FF_CASES; a++) {
+		stats[a].avgFound /= trials;
+		stats[a].avgNotFound /= trials;
+		stats[a].maxFound /= trials;
+		stats[a].maxNotFound /= trials;
+		stats[a].nsPerFind /= trials;
 	}
+}
+
+void averageSearch(TableOps *ops) {
+	SearchStats stats[FF_CASES];
+	searchEffort(ops, KEYS_UNIFORM, AVG_CASE_TRIALS, stats);
 
 	// pretty print table
-	printf("a=%d, b=%d\n", a_ct, b_ct);
+	printf("%s, a=%d, b=%d\n", ops->name, a_ct, b_ct);
 	printf("-----------------------------------");
-	printf("-------------------------------\n");
-	printf("|FF  |\tAvgFound|  AvgNotFound  |      MaxFound |\tMaxNotF |\n");
-	for (int i=0; i < cases; i++) {
+	printf("----------------------------------------------\n");
+	printf("|FF  |\tAvgFound|  AvgNotFound  |      MaxFound |\tMaxNotF |\tns/find |\n");
+	for (int i=0; i < FF_CASES; i++) {
 		printf("-----------------------------------");
-		printf("-------------------------------\n");
-		printf("|%3.2f|\t%8.2f|\t%8.2f|\t%8.2f|\t%8.2f|\n", fillFactor[i],
-			avgEffortFound[i], avgEffortNotFound[i],
-			maxEffortFound[i], maxEffortNotFound[i]);
+		printf("----------------------------------------------\n");
+		if (stats[i].full) {
+			printf("|%3.2f|\t    full|\t    full|\t    full|\t    full|\t    full|\n", fillFactor[i]);
+			continue;
+		}
+		printf("|%3.2f|\t%8.2f|\t%8.2f|\t%8.2f|\t%8.2f|\t%8.2f|\n", fillFactor[i],
+			stats[i].avgFound, stats[i].avgNotFound,
+			stats[i].maxFound, stats[i].maxNotFound, stats[i].nsPerFind);
 	}
 	printf("-----------------------------------");
-	printf("-------------------------------\n");
+	printf("----------------------------------------------\n");
 
 }
 
+// every hash function with every probe sequence on the flat table, at FF 0.9 and 0.99
+void hashComparison() {
+	const char *keyNames[] = { "uniform", "sequential", "adversarial" };
+	const char *hashNames[] = { "identity", "multiply-shift", "fibonacci", "murmur", "wyhash", "tabulation" };
+	HashFn hashes[] = { hashIdentity, hashMultiplyShift, hashFibonacci, hashMurmur, hashWyhash, hashTabulation };
+	const char *probeNames[] = { "linear", "quadratic", "double" };
+	ProbeFn probes[] = { probeLinear, probeQuadratic, probeDouble };
+	SearchStats stats[FF_CASES];
+
+	printf("\nflat table, a=%d, b=%d, effort at FF 0.90 | 0.99\n", a_ct, b_ct);
+	printf("%-11s | %-14s | %-9s | %8s %8s | %8s %8s %8s | %8s\n", "keys", "hash", "probe",
+		"AvgFnd", "AvgNotF", "AvgFnd", "AvgNotF", "MaxNotF", "ns/find");
+
+	for (int ks=0; ks < 3; ks++)
+		for (int h=0; h < 6; h++)
+			for (int p=0; p < 3; p++) {
+				hashFn = hashes[h];
+				probeFn = probes[p];
+				searchEffort(&tables[1], ks, HASH_CASE_TRIALS, stats);
+
+				SearchStats *s90 = &stats[2], *s99 = &stats[4];
+				printf("%-11s | %-14s | %-9s | ", keyNames[ks], hashNames[h], probeNames[p]);
+				if (s90->full)
+					printf("%17s | ", "full");
+				else
+					printf("%8.2f %8.2f | ", s90->avgFound, s90->avgNotFound);
+				if (s99->full)
+					printf("%26s | %8s\n", "full", "-");
+				else
+					printf("%8.2f %8.2f %8.2f | %8.2f\n", s99->avgFound, s99->avgNotFound, s99->maxNotFound, s99->nsPerFind);
+			}
+
+	hashFn = hashIdentity;
+	probeFn = probeQuadratic;
+}
+
+int cmpDouble(const void *a, const void *b) {
+	double x = *(const double*) a, y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+// per insert latency while a GrowTable grows from 16 slots to GROW_TEST_N keys
+void grow_test() {
+	int n = GROW_TEST_N;
+	double *lat = (double*) malloc(n * sizeof(double));
+	unsigned int *ids = (unsigned int*) malloc(n * sizeof(unsigned int));
+	assert(lat != NULL && ids != NULL);
+
+	for (int i=0; i < n; i++)
+		ids[i] = 1 + rngBounded(UINT_MAX - 1);
+
+	printf("\n%d inserts into a growing table (ns)\n", n);
+	printf("%12s | %8s | %8s | %10s | %12s | %10s\n", "rehash", "p50", "p99", "p999", "max", "total_ms");
+
+	for (int mode=0; mode < 2; mode++) {
+		GrowTable *G = createGrowTable(16, mode == 0 ? 0 : GROW_MIGRATE);
+		auto begin = std::chrono::steady_clock::now();
+
+		for (int i=0; i < n; i++) {
+			auto start = std::chrono::steady_clock::now();
+			growInsert(G, ids[i]);
+			lat[i] = std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+
+		double totalMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - begin).count();
+
+		for (int i=0; i < n; i += 97)
+			assert(growFind(G, ids[i]));
+
+		qsort(lat, n, sizeof(double), cmpDouble);
+		printf("%12s | %8.0f | %8.0f | %10.0f | %12.0f | %10.1f\n", mode == 0 ? "all at once" : "incremental",
+			lat[n/2], lat[(int) (n * 0.99)], lat[(int) (n * 0.999)], lat[n-1], totalMs);
+
+		freeGrowTable(G);
+	}
+
+	free(lat);
+	free(ids);
+}
+
+// one thread of concurrent_test: ops finds or inserts, writePercent of them inserts
+void concurrentWorker(ConcurrentTable *T, const unsigned int *prefill, int ops, int writePercent, int stream) {
+	rngSeedThread(RNG_SEED, stream);
+	int reads = 0, found = 0;
+
+	for (int i=0; i < ops; i++) {
+		if ((int) rngBounded(100) < writePercent) {
+			concurrentInsert(T, 1 + rngBounded(UINT_MAX - 1));
+		} else {
+			reads++;
+			found += concurrentFind(T, prefill[rngBounded(CONC_TEST_PREFILL)]);
+		}
+	}
+
+	// every find is for a key inserted before the threads started
+	assert(found == reads);
+}
+
+// throughput of the CAS table for a read-heavy and a write-heavy mix
+void concurrent_test() {
+	int mixes[] = { 5, 50 };	// % inserts
+	unsigned int *prefill = (unsigned int*) malloc(CONC_TEST_PREFILL * sizeof(unsigned int));
+	assert(prefill != NULL);
+
+	printf("\nconcurrent table, %d slots, %d keys before, %d operations\n",
+		CONC_TEST_SLOTS, CONC_TEST_PREFILL, CONC_TEST_OPS);
+	printf("%8s | %8s | %10s | %10s\n", "mix", "threads", "ms", "Mops/s");
+
+	for (int mi=0; mi < 2; mi++)
+		for (int threads=1; threads <= 64; threads *= 2) {
+			ConcurrentTable *T = createConcurrentTable(CONC_TEST_SLOTS);
+			for (int i=0; i < CONC_TEST_PREFILL; i++) {
+				prefill[i] = 1 + rngBounded(UINT_MAX - 1);
+				concurrentInsert(T, prefill[i]);
+			}
+
+			std::vector<std::thread> pool;
+			int ops = CONC_TEST_OPS / threads;
+
+			auto start = std::chrono::steady_clock::now();
+			for (int t=0; t < threads; t++)
+				pool.push_back(std::thread(concurrentWorker, T, prefill, ops, mixes[mi], t + 1));
+			for (auto &th : pool)
+				th.join();
+			double ms = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+
+			char mix[16];
+			sprintf(mix, "%d/%d", 100 - mixes[mi], mixes[mi]);
+			printf("%8s | %8d | %10.1f | %10.2f\n", mix, threads, ms, (double) ops * threads / ms / 1000);
+
+			freeConcurrentTable(T);
+		}
+
+	free(prefill);
+}
+
+// one flatFind per id vs flatFindBatch, for tables from in cache to far past it
+void batch_test() {
+	int n = BATCH_TEST_LOOKUPS;
+	unsigned int *lookups = (unsigned int*) malloc(n * sizeof(unsigned int));
+	int *out = (int*) malloc(n * sizeof(int));
+	assert(lookups != NULL && out != NULL);
+
+	printf("\n%d lookups, half present, FF 0.8 (ns per lookup)\n", n);
+	printf("%10s | %10s | %10s | %10s | %8s\n", "slots", "keys_MB", "flatFind", "batch", "speedup");
+
+	for (int slots = 1 << 16; slots <= BATCH_TEST_MAX_SLOTS; slots *= 4) {
+		FlatTable *T = createFlatTable(nextPrime(slots));
+		int size = T->m * 0.8;
+		unsigned int *ids = (unsigned int*) malloc(size * sizeof(unsigned int));
+		assert(ids != NULL);
+
+		for (int i=0; i < size; i++) {
+			ids[i] = 1 + rngBounded(UINT_MAX - 1);
+			flatInsert(T, ids[i]);
+		}
+
+		for (int i=0; i < n; i++)
+			lookups[i] = i % 2 ? ids[rngBounded(size)] : 1 + rngBounded(UINT_MAX - 1);
+
+		// both loops run once untimed, so neither is timed on a cold table
+		int hits = 0;
+		double singleNs = 0, batchNs = 0;
+		for (int pass=0; pass < 2; pass++) {
+			auto start = std::chrono::steady_clock::now();
+			hits = 0;
+			for (int i=0; i < n; i++)
+				hits += flatFind(T, lookups[i]);
+			singleNs = std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count() / n;
+
+			start = std::chrono::steady_clock::now();
+			flatFindBatch(T, lookups, n, out);
+			batchNs = std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count() / n;
+		}
+
+		int batchHits = 0;
+		for (int i=0; i < n; i++) {
+			batchHits += out[i] >= 0;
+			assert(out[i] < 0 || T->keys[out[i]] == lookups[i]);
+		}
+		assert(hits == batchHits);
+
+		printf("%10d | %10.1f | %10.1f | %10.1f | %8.2f\n", T->m, T->m * sizeof(unsigned int) / 1048576.0,
+			singleNs, batchNs, singleNs / batchNs);
+
+		freeFlatTable(T);
+		free(ids);
+	}
+
+	free(lookups);
+	free(out);
+}
+
 int main() {
+	rngSeed(RNG_SEED);
+	hashFnsSeed();
 	demo();
-	averageSearch();
+
+	for (int i=0; i < (int) (sizeof(tables) / sizeof(tables[0])); i++)
+		averageSearch(&tables[i]);
+
+	// every hash function x probe sequence x key set on the flat table
+	hashComparison();
+
+	// grow_test();
+	// concurrent_test();
+	// batch_test();
+	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+/*	Robin Hood hashing: linear probing where the richer key gives way.
+
+	- every used slot stores dist, how far its key is from its home slot
+	  hash_(id) % m; an insert that meets a key closer to home than
+	  itself takes that slot and carries the evicted key on, so probe
+	  lengths stay close to the average instead of a long tail
+	- a search for id stops at an empty slot or at the first slot whose
+	  key is closer to home than id would be there: id would have evicted
+	  it, so absent keys end early
+	- erase shifts the following keys of the cluster one slot back until
+	  an empty slot or a key already at home; no tombstones are left
+
+	countOperations: one per id compared
+*/
+
+#ifndef ROBINHOOD_H
+#define ROBINHOOD_H
+
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+extern unsigned int countOperations;
+unsigned int hash_(unsigned int key);
+
+// id 0 marks an empty slot
+typedef struct {
+	int m;
+	unsigned int *keys;
+	int *dist;		// distance from the home slot
+	char **names;	// names[i] belongs to keys[i]
+} RobinTable;
+
+RobinTable *createRobinTable(int m) {
+	RobinTable *T = (RobinTable*) malloc(sizeof(RobinTable));
+	assert(T != NULL);
+
+	T->m = m;
+	T->keys = (unsigned int*) calloc(m, sizeof(unsigned int));
+	T->dist = (int*) calloc(m, sizeof(int));
+	T->names = (char**) calloc(m, sizeof(char*));
+	assert(T->keys != NULL && T->dist != NULL && T->names != NULL);
+
+	return T;
+}
+
+void emptyRobinTable(RobinTable *T) {
+	for (int i=0; i < T->m; i++)
+		free(T->names[i]);
+
+	memset(T->keys, 0, T->m * sizeof(unsigned int));
+	memset(T->names, 0, T->m * sizeof(char*));
+}
+
+void freeRobinTable(RobinTable *T) {
+	emptyRobinTable(T);
+	free(T->keys);
+	free(T->dist);
+	free(T->names);
+	free(T);
+}
+
+// the name is copied, like createEntry does
+void robinInsert(RobinTable *T, unsigned int id, char *name = NULL) {
+	assert(id != 0);
+	int m = T->m, pos = hash_(id) % m, d = 0;
+	char *copy = NULL;
+
+	if (name) {
+		copy = (char*) malloc(strlen(name) + 1);
+		strcpy(copy, name);
+	}
+
+	for (int i=0; i < m; i++) {
+		if (T->keys[pos] == 0) {
+			T->keys[pos] = id;
+			T->dist[pos] = d;
+			T->names[pos] = copy;
+			return;
+		}
+
+		// the key here is closer to home: it gives its slot up
+		if (T->dist[pos] < d) {
+			unsigned int k = T->keys[pos];
+			int kd = T->dist[pos];
+			char *kn = T->names[pos];
+
+			T->keys[pos] = id;
+			T->dist[pos] = d;
+			T->names[pos] = copy;
+			id = k;
+			d = kd;
+			copy = kn;
+		}
+
+		pos = (pos + 1) % m;
+		d++;
+	}
+
+	assert(!"robin hood table full");
+}
+
+// slot of id or -1
+int robinSearch(RobinTable *T, unsigned int id) {
+	int m = T->m, pos = hash_(id) % m;
+
+	for (int d=0; d < m; d++) {
+		if (T->keys[pos] == 0 || T->dist[pos] < d)
+			return -1;
+
+		countOperations++;
+		if (T->keys[pos] == id)	// cmp++
+			return pos;
+
+		pos = (pos + 1) % m;
+	}
+
+	return -1;
+}
+
+// no allocation: the name (may be NULL) goes to *name if it is not NULL
+bool robinFind(RobinTable *T, unsigned int id, char **name = NULL) {
+	int pos = robinSearch(T, id);
+
+	if (pos < 0)
+		return false;
+
+	if (name)
+		*name = T->names[pos];
+	return true;
+}
+
+// backward shift, no tombstones
+bool robinErase(RobinTable *T, unsigned int id) {
+	int m = T->m, pos = robinSearch(T, id);
+
+	if (pos < 0)
+		return false;
+
+	free(T->names[pos]);
+
+	for (int next = (pos + 1) % m; T->keys[next] != 0 && T->dist[next] > 0; next = (next + 1) % m) {
+		T->keys[pos] = T->keys[next];
+		T->dist[pos] = T->dist[next] - 1;
+		T->names[pos] = T->names[next];
+		pos = next;
+	}
+
+	T->keys[pos] = 0;
+	T->names[pos] = NULL;
+	return true;
+}
+
+// longest distance from home, the worst case of a successful search
+int robinMaxDist(RobinTable *T) {
+	int best = 0;
+
+	for (int i=0; i < T->m; i++)
+		if (T->keys[i] != 0 && T->dist[i] > best)
+			best = T->dist[i];
+
+	return best;
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*	Open addressing with one control byte per slot (Swiss table style).
+
+	- the slots are split in groups of 16; ctrl[i] is EMPTY, DELETED or,
+	  for a used slot, the top 7 bits of the key's 64 bit hash
+	- a lookup loads the 16 control bytes of a group, compares them all
+	  with the key's 7 bit tag (SSE2 cmpeq + movemask) and only compares
+	  the ids of the slots whose tag matches; a group with an EMPTY slot
+	  ends the search
+	- groups are probed quadratically (triangular numbers); the number
+	  of groups is not a power of two, so the triangular sequence may
+	  miss some, and after one round it goes on linearly to reach them all
+	- erase writes EMPTY when the group still has an empty slot (no
+	  search went past it) and DELETED otherwise
+
+	countOperations: one per group scanned and one per id compared
+*/
+
+#ifndef SWISSTABLE_H
+#define SWISSTABLE_H
+
+#include "../common/cpu.h"
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+#define SWISS_GROUP 16
+#define SWISS_EMPTY ((int8_t) -128)
+#define SWISS_DELETED ((int8_t) -2)
+
+extern unsigned int countOperations;
+
+typedef struct {
+	int groups;
+	int8_t *ctrl;		// groups * SWISS_GROUP bytes
+	unsigned int *keys;
+	char **names;		// names[i] belongs to keys[i]
+} SwissTable;
+
+SwissTable *createSwissTable(int m) {
+	SwissTable *T = (SwissTable*) malloc(sizeof(SwissTable));
+	assert(T != NULL);
+
+	T->groups = (m + SWISS_GROUP - 1) / SWISS_GROUP;
+	int slots = T->groups * SWISS_GROUP;
+
+	T->ctrl = (int8_t*) malloc(slots);
+	T->keys = (unsigned int*) calloc(slots, sizeof(unsigned int));
+	T->names = (char**) calloc(slots, sizeof(char*));
+	assert(T->ctrl != NULL && T->keys != NULL && T->names != NULL);
+	memset(T->ctrl, SWISS_EMPTY, slots);
+
+	return T;
+}
+
+void emptySwissTable(SwissTable *T) {
+	int slots = T->groups * SWISS_GROUP;
+
+	for (int i=0; i < slots; i++)
+		free(T->names[i]);
+
+	memset(T->ctrl, SWISS_EMPTY, slots);
+	memset(T->names, 0, slots * sizeof(char*));
+}
+
+void freeSwissTable(SwissTable *T) {
+	emptySwissTable(T);
+	free(T->ctrl);
+	free(T->keys);
+	free(T->names);
+	free(T);
+}
+
+static inline uint64_t swissHash(unsigned int id) {
+	return (uint64_t) id * 0x9E3779B97F4A7C15ull;
+}
+
+// the i-th group probed for hash h, every group is reached for i < 2 * groups
+static inline int swissGroup(uint64_t h, int i, int groups) {
+	uint64_t step = i < groups ? (uint64_t) i * (i+1) / 2 : (uint64_t) i;
+	return (int) (((h >> 32) + step) % groups);
+}
+
+// bit s set if ctrl[s] == tag
+static inline unsigned swissMatch(const int8_t *ctrl, int8_t tag) {
+#ifdef CPU_X86
+	__m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+	unsigned mask = 0;
+	for (int s=0; s < SWISS_GROUP; s++)
+		mask |= (unsigned) (ctrl[s] == tag) << s;
+	return mask;
+#endif
+}
+
+// bit s set if ctrl[s] is EMPTY or DELETED, both have the sign bit set
+static inline unsigned swissMatchFree(const int8_t *ctrl) {
+#ifdef CPU_X86
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) ctrl));
+#else
+	unsigned mask = 0;
+	for (int s=0; s < SWISS_GROUP; s++)
+		mask |= (unsigned) (ctrl[s] < 0) << s;
+	return mask;
+#endif
+}
+
+// the name is copied, like createEntry does
+void swissInsert(SwissTable *T, unsigned int id, char *name = NULL) {
+	uint64_t h = swissHash(id);
+
+	for (int i=0; i < 2 * T->groups; i++) {
+		int g = swissGroup(h, i, T->groups);
+		unsigned mask = swissMatchFree(T->ctrl + g * SWISS_GROUP);
+
+		if (mask != 0) {
+			int slot = g * SWISS_GROUP + __builtin_ctz(mask);
+
+			T->ctrl[slot] = (int8_t) (h >> 57);
+			T->keys[slot] = id;
+			free(T->names[slot]);
+			T->names[slot] = NULL;
+			if (name) {
+				T->names[slot] = (char*) malloc(strlen(name) + 1);
+				strcpy(T->names[slot], name);
+			}
+			return;
+		}
+	}
+
+	assert(!"swiss table full");
+}
+
+// slot of id or -1
+int swissSearch(SwissTable *T, unsigned int id) {
+	uint64_t h = swissHash(id);
+	int8_t tag = (int8_t) (h >> 57);
+
+	for (int i=0; i < 2 * T->groups; i++) {
+		int g = swissGroup(h, i, T->groups);
+		const int8_t *ctrl = T->ctrl + g * SWISS_GROUP;
+
+		countOperations++;
+		for (unsigned mask = swissMatch(ctrl, tag); mask != 0; mask &= mask - 1) {
+			int slot = g * SWISS_GROUP + __builtin_ctz(mask);
+
+			countOperations++;
+			if (T->keys[slot] == id)	// cmp++
+				return slot;
+		}
+
+		if (swissMatch(ctrl, SWISS_EMPTY) != 0)
+			return -1;
+	}
+
+	return -1;
+}
+
+// no allocation: the name (may be NULL) goes to *name if it is not NULL
+bool swissFind(SwissTable *T, unsigned int id, char **name = NULL) {
+	int slot = swissSearch(T, id);
+
+	if (slot < 0)
+		return false;
+
+	if (name)
+		*name = T->names[slot];
+	return true;
+}
+
+bool swissErase(SwissTable *T, unsigned int id) {
+	int slot = swissSearch(T, id);
+
+	if (slot < 0)
+		return false;
+
+	int8_t *group = T->ctrl + slot / SWISS_GROUP * SWISS_GROUP;
+	T->ctrl[slot] = swissMatch(group, SWISS_EMPTY) != 0 ? SWISS_EMPTY : SWISS_DELETED;
+	return true;
+}
+
+#endif
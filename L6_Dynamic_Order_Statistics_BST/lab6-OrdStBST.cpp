@@ -4,6 +4,7 @@
 */
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
@@ -47,13 +48,13 @@ void evaluateEffort();
 Profiler profiler("Dynamic_Order_Statistics");
 
 int main() {
-	srand48(time(NULL));
+	rngSeed(RNG_SEED);
 	demo();
 	// evaluateEffort();
 }
 
 int getRandom(int max) {
-	return (int) 1 + drand48() * (max - 1);
+	return 1 + (int) rngBounded(max);	// rank in [1, max]
 }
 
 Node* newNode(int key) {
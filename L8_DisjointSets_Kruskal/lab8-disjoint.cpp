@@ -1,4 +1,5 @@
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -55,7 +56,7 @@ Edge** buildRandomEdges(int V);
 unsigned int countOperations = 0;
 
 int main() {
-	srand48(time(NULL));
+	rngSeed(RNG_SEED);
 	demo();
 	testKruskal();
 	//evaluateEffort();
@@ -64,7 +65,7 @@ int main() {
 
 void demo() {
 	int arr[DEMO_SIZE];
-	FillRandomArray(arr, DEMO_SIZE, 10, 200, false, UNSORTED);
+	rngFillArray(arr, DEMO_SIZE, 10, 200, false, UNSORTED);
 	
 	TreeNode *forest[DEMO_SIZE];
 	for (int i=0; i < DEMO_SIZE; i++)
@@ -161,11 +162,9 @@ void evaluateEffort() {
 	profiler.showReport();
 }
 
+// uniform in [0, max]
 unsigned int getRandom(int max) {
-	double d = drand48();  // gives you a double from 0 to 1
-	double val = d * max;	  // gives you a double from 0 to max
-
-	return (unsigned int) round(val);
+	return rngBounded(max + 1);
 }
 
 int cmpEdge(const void* a, const void* b) {
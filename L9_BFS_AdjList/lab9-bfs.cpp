@@ -10,6 +10,7 @@
 */
 
 #include "profiler/Profiler.h"
+#include "../common/rng.h"
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -290,11 +291,9 @@ bool edgeExists(Graph* G, int a, int b) {
 	return foundVtoU;
 }
 
+// uniform in [0, max]
 unsigned int getRandom(int max) {
-	double d = drand48();  // gives you a double from 0 to 1
-	double val = d * max;	  // gives you a double from 0 to max
-
-	return (unsigned int) round(val);
+	return rngBounded(max + 1);
 }
 
 Graph* generateRandomGraph(int V, int E) {
@@ -354,7 +353,7 @@ void evaluateBFS() {
 }
 
 int main() {
-	srand48(time(NULL));
+	rngSeed(RNG_SEED);
 	edges = (bool**) calloc(300, sizeof(bool*));
 	for (int i=0; i < 300; i++) {
 		edges[i] = (bool*) calloc(300, sizeof(bool));
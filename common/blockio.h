@@ -0,0 +1,231 @@
+/*	Double-buffered block readers and writers for int files.
+
+	- a reader owns two blocks: while the caller consumes one, a
+	  background thread fills the other with one large pread()
+	- a writer does the same the other way around, the full block is
+	  written by a background pwrite() while the next one is filled
+	- blocks are plain buffered IO with POSIX_FADV_SEQUENTIAL; O_DIRECT
+	  would need aligned buffers and sizes for no gain at these block sizes
+	- memory use is exactly 2 blocks per reader or writer
+	- a failed or short read ends the reader early and a failed write
+	  stops the writer; readerClose() / writerClose() report it
+
+	compile with -pthread
+*/
+
+#ifndef BLOCKIO_H
+#define BLOCKIO_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <thread>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+typedef struct {
+	int fd;
+	int64_t next, end;		// byte range still to be read
+	int *buf[2];
+	int len[2];				// ints held by each block
+	int blockInts;
+	int cur, pos;
+	std::thread *pending;	// fills buf[cur^1]
+	bool failed;			// set by the reading thread
+} BlockReader;
+
+typedef struct {
+	int fd;
+	int64_t next;			// byte offset of the next block
+	int *buf[2];
+	int blockInts;
+	int cur, pos;
+	std::thread *pending;	// writes buf[cur^1]
+	bool failed;			// set by the writing thread
+} BlockWriter;
+
+// false on a read error or if the file ends before offset + bytes, *len is 0 then
+static bool blockFill(int fd, int *buf, int *len, int64_t offset, int64_t bytes) {
+	int64_t done = 0;
+	*len = 0;
+
+	while (done < bytes) {
+		ssize_t got = pread(fd, (char*) buf + done, bytes - done, offset + done);
+
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return false;
+		done += got;
+	}
+
+	*len = (int) (bytes / sizeof(int));
+	return true;
+}
+
+static bool blockFlush(int fd, int *buf, int64_t bytes, int64_t offset) {
+	int64_t done = 0;
+
+	while (done < bytes) {
+		ssize_t put = pwrite(fd, (char*) buf + done, bytes - done, offset + done);
+
+		if (put < 0 && errno == EINTR)
+			continue;
+		if (put <= 0)
+			return false;
+		done += put;
+	}
+
+	return true;
+}
+
+static void readerFillTask(BlockReader *r, int which, int64_t offset, int64_t bytes) {
+	if (!blockFill(r->fd, r->buf[which], &r->len[which], offset, bytes))
+		r->failed = true;
+}
+
+static void writerFlushTask(BlockWriter *w, int which, int64_t bytes, int64_t offset) {
+	if (!blockFlush(w->fd, w->buf[which], bytes, offset))
+		w->failed = true;
+}
+
+static void readerPrefetch(BlockReader *r) {
+	int other = r->cur ^ 1;
+	int64_t bytes = r->end - r->next;
+	if (bytes > (int64_t) r->blockInts * (int64_t) sizeof(int))
+		bytes = (int64_t) r->blockInts * sizeof(int);
+
+	if (bytes <= 0) {
+		r->len[other] = 0;
+		return;
+	}
+
+	r->pending = new std::thread(readerFillTask, r, other, r->next, bytes);
+	r->next += bytes;
+}
+
+// reads the ints in bytes [offset, offset + bytes) of fd
+void readerOpen(BlockReader *r, int fd, int64_t offset, int64_t bytes, int blockInts) {
+	assert(r != NULL && blockInts > 0);
+
+	r->fd = fd;
+	r->next = offset;
+	r->end = offset + bytes;
+	r->blockInts = blockInts;
+	r->buf[0] = (int*) malloc(blockInts * sizeof(int));
+	r->buf[1] = (int*) malloc(blockInts * sizeof(int));
+	assert(r->buf[0] != NULL && r->buf[1] != NULL);
+	r->len[0] = r->len[1] = 0;
+	r->pending = NULL;
+	r->failed = false;
+	posix_fadvise(fd, offset, bytes, POSIX_FADV_SEQUENTIAL);
+
+	// block 0 is read right away, block 1 in the background
+	r->cur = 1;
+	readerPrefetch(r);
+	if (r->pending) {
+		r->pending->join();
+		delete r->pending;
+		r->pending = NULL;
+	}
+	r->cur = 0;
+	r->pos = 0;
+	readerPrefetch(r);
+}
+
+// switches to the prefetched block, false once the range is exhausted
+static bool readerSwap(BlockReader *r) {
+	if (r->pending) {
+		r->pending->join();
+		delete r->pending;
+		r->pending = NULL;
+	}
+
+	r->cur ^= 1;
+	r->pos = 0;
+
+	if (r->len[r->cur] == 0)
+		return false;
+
+	readerPrefetch(r);
+	return true;
+}
+
+static inline bool readerNext(BlockReader *r, int *val) {
+	if (r->pos == r->len[r->cur] && !readerSwap(r))
+		return false;
+
+	*val = r->buf[r->cur][r->pos++];
+	return true;
+}
+
+// false if a read failed, the ints seen so far are then only a prefix of the range
+bool readerClose(BlockReader *r) {
+	if (r->pending) {
+		r->pending->join();
+		delete r->pending;
+	}
+
+	free(r->buf[0]);
+	free(r->buf[1]);
+	return !r->failed;
+}
+
+void writerOpen(BlockWriter *w, int fd, int64_t offset, int blockInts) {
+	assert(w != NULL && blockInts > 0);
+
+	w->fd = fd;
+	w->next = offset;
+	w->blockInts = blockInts;
+	w->buf[0] = (int*) malloc(blockInts * sizeof(int));
+	w->buf[1] = (int*) malloc(blockInts * sizeof(int));
+	assert(w->buf[0] != NULL && w->buf[1] != NULL);
+	w->cur = w->pos = 0;
+	w->pending = NULL;
+	w->failed = false;
+}
+
+static void writerSwap(BlockWriter *w) {
+	if (w->pending) {
+		w->pending->join();
+		delete w->pending;
+		w->pending = NULL;
+	}
+
+	// after a failed write the rest is dropped, writerClose reports it
+	if (w->pos == 0 || w->failed) {
+		w->pos = 0;
+		return;
+	}
+
+	int64_t bytes = (int64_t) w->pos * sizeof(int);
+	w->pending = new std::thread(writerFlushTask, w, w->cur, bytes, w->next);
+	w->next += bytes;
+	w->cur ^= 1;
+	w->pos = 0;
+}
+
+static inline void writerPut(BlockWriter *w, int val) {
+	w->buf[w->cur][w->pos++] = val;
+
+	if (w->pos == w->blockInts)
+		writerSwap(w);
+}
+
+// flushes everything, returns the offset just past the written data or -1 if a write failed
+int64_t writerClose(BlockWriter *w) {
+	writerSwap(w);
+
+	if (w->pending) {
+		w->pending->join();
+		delete w->pending;
+	}
+
+	free(w->buf[0]);
+	free(w->buf[1]);
+	return w->failed ? -1 : w->next;
+}
+
+#endif
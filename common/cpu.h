@@ -0,0 +1,50 @@
+/*	Runtime CPU feature detection for the SIMD kernels.
+
+	- the kernels are compiled with __attribute__((target(...))), so the
+	  labs still build without -mavx2 and run on any x86-64 machine
+	- the environment variable SIMD_LEVEL caps the level that is used
+	  (0 = scalar, 1 = SSE2, 2 = AVX2, 3 = AVX-512), which is handy to
+	  benchmark the fallbacks on the same machine
+*/
+
+#ifndef CPU_H
+#define CPU_H
+
+#include <cstdlib>
+
+#define SIMD_SCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+#define SIMD_AVX512 3
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#include <immintrin.h>
+#endif
+
+static int cpuDetectSimd() {
+	int level = SIMD_SCALAR;
+
+#ifdef CPU_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		level = SIMD_SSE2;
+	if (__builtin_cpu_supports("avx2"))
+		level = SIMD_AVX2;
+	if (__builtin_cpu_supports("avx512f"))
+		level = SIMD_AVX512;
+#endif
+
+	const char *cap = getenv("SIMD_LEVEL");
+	if (cap != NULL && atoi(cap) < level)
+		level = atoi(cap);
+
+	return level;
+}
+
+int cpuSimdLevel() {
+	static int level = cpuDetectSimd();
+	return level;
+}
+
+#endif
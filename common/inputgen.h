@@ -0,0 +1,214 @@
+/*	Input generators for the sorting sweeps.
+
+	- every generator writes straight into a caller buffer, runs in O(n)
+	  (the adversary in O(cost of the attacked sort)) and never allocates
+	- random draws come from common/rng.h, so inputs repeat with the seed
+
+	GENERATORS:
+	- genBestCasePO:   postorder of the perfectly balanced BST over a
+	                   sorted array, the best case of a last-element pivot
+	- genAntiQuicksort: McIlroy's "killer adversary" (1999), values are
+	                   decided lazily while the attacked sort is running
+	- genOrganPipe:    ascending then descending
+	- genSawtooth:     repeated ascending ramps of a given period
+	- genFewUnique:    uniform draws from only a few distinct keys
+	- genZipf:         Zipf distributed keys, rejection-inversion sampling
+	                   (Hormann, Derflinger), O(1) per key
+*/
+
+#ifndef INPUTGEN_H
+#define INPUTGEN_H
+
+#include "rng.h"
+#include <stdint.h>
+#include <cmath>
+#include <cassert>
+
+typedef int (*GenCmp)(int x, int y);
+typedef void (*GenSortFn)(int *idx, int n, GenCmp cmp);
+
+static void genPostOrder(const int *sorted, int *out, int start, int end, int *offset) {
+	if (start > end)
+		return;
+
+	int mid = (start + end)/2;
+	genPostOrder(sorted, out, start, mid-1, offset);
+	genPostOrder(sorted, out, mid+1, end, offset);
+	out[(*offset)++] = sorted[mid];
+}
+
+// sorted and out must not overlap
+void genBestCasePO(const int *sorted, int *out, int n) {
+	int offset = 0;
+	genPostOrder(sorted, out, 0, n-1, &offset);
+}
+
+// McIlroy adversary state, one per thread
+static thread_local int *genAqVal;
+static thread_local int genAqGas, genAqNSolid, genAqCandidate;
+
+static int genAqCmp(int x, int y) {
+	if (genAqVal[x] == genAqGas && genAqVal[y] == genAqGas) {
+		if (x == genAqCandidate)
+			genAqVal[x] = genAqNSolid++;
+		else
+			genAqVal[y] = genAqNSolid++;
+	}
+
+	if (genAqVal[x] == genAqGas)
+		genAqCandidate = x;
+	else if (genAqVal[y] == genAqGas)
+		genAqCandidate = y;
+
+	return genAqVal[x] - genAqVal[y];
+}
+
+/*	out receives a permutation of base..base+n-1 that drives sortFn into
+	its worst case; idx is caller scratch of n ints that sortFn permutes.
+	sortFn must make the same pivot choices as the sort being attacked,
+	for a randomized sort reseed the rng identically before both runs.
+*/
+void genAntiQuicksort(int *out, int *idx, int n, GenSortFn sortFn, int base = 0) {
+	genAqVal = out;
+	genAqGas = n;	// larger than every frozen value
+	genAqNSolid = 0;
+	genAqCandidate = 0;
+
+	for (int i=0; i < n; i++) {
+		idx[i] = i;
+		out[i] = genAqGas;
+	}
+
+	sortFn(idx, n, genAqCmp);
+
+	// items never compared against each other may be frozen in any order
+	for (int i=0; i < n; i++) {
+		if (out[i] == genAqGas)
+			out[i] = genAqNSolid++;
+		out[i] += base;
+	}
+}
+
+// mirrors of the lab3 quicksort pivot rules, for genAntiQuicksort
+static int genLomutoCmp(int *a, int l, int r, GenCmp cmp) {
+	int x = a[r];
+	int i = l-1;
+
+	for (int j=l; j < r; j++)
+		if (cmp(a[j], x) <= 0) {
+			i++;
+			int tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+		}
+
+	int tmp = a[i+1]; a[i+1] = a[r]; a[r] = tmp;
+	return i+1;
+}
+
+static void genQuicksortLastCmp(int *a, int l, int r, GenCmp cmp) {
+	if (l >= r)
+		return;
+
+	int m = genLomutoCmp(a, l, r, cmp);
+	genQuicksortLastCmp(a, l, m-1, cmp);
+	genQuicksortLastCmp(a, m+1, r, cmp);
+}
+
+static void genQuicksortRandCmp(int *a, int l, int r, GenCmp cmp) {
+	if (l >= r)
+		return;
+
+	int i = l + rngBounded(r-l+1);
+	int tmp = a[r]; a[r] = a[i]; a[i] = tmp;
+
+	int m = genLomutoCmp(a, l, r, cmp);
+	genQuicksortRandCmp(a, l, m-1, cmp);
+	genQuicksortRandCmp(a, m+1, r, cmp);
+}
+
+void genSortLastPivot(int *idx, int n, GenCmp cmp) {
+	genQuicksortLastCmp(idx, 0, n-1, cmp);
+}
+
+void genSortRandomPivot(int *idx, int n, GenCmp cmp) {
+	genQuicksortRandCmp(idx, 0, n-1, cmp);
+}
+
+// lo ... hi ... lo
+void genOrganPipe(int *out, int n, int lo, int hi) {
+	int half = (n+1)/2;
+
+	for (int i=0; i < half; i++)
+		out[i] = lo + (half > 1 ? (int) ((int64_t) (hi - lo) * i / (half - 1)) : 0);
+
+	for (int i=half; i < n; i++)
+		out[i] = out[n-1-i];
+}
+
+// ramps lo..hi repeated every period elements
+void genSawtooth(int *out, int n, int period, int lo, int hi) {
+	assert(period > 0);
+
+	for (int i=0, t=0; i < n; i++) {
+		out[i] = lo + (period > 1 ? (int) ((int64_t) (hi - lo) * t / (period - 1)) : 0);
+		if (++t == period)
+			t = 0;
+	}
+}
+
+// uniform draws among `distinct` evenly spaced keys in [lo, hi]
+void genFewUnique(int *out, int n, int distinct, int lo, int hi) {
+	assert(distinct > 0);
+	int64_t step = distinct > 1 ? ((int64_t) hi - lo) / (distinct - 1) : 0;
+
+	for (int i=0; i < n; i++)
+		out[i] = (int) (lo + step * rngBounded(distinct));
+}
+
+static inline double genZipfHelper1(double x) {
+	return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0/3 - 0.25 * x));
+}
+
+static inline double genZipfHelper2(double x) {
+	return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0/3) * (1 + 0.25 * x));
+}
+
+static inline double genZipfH(double x, double s) {
+	double logX = log(x);
+	return genZipfHelper2((1 - s) * logX) * logX;
+}
+
+static inline double genZipfHinv(double x, double s) {
+	double t = x * (1 - s);
+	if (t < -1)
+		t = -1;
+	return exp(genZipfHelper1(t) * x);
+}
+
+// key lo+r-1 where rank r in [1, hi-lo+1] has probability ~ 1/r^s
+void genZipf(int *out, int n, int lo, int hi, double s) {
+	assert(lo <= hi && s > 0);
+	int N = hi - lo + 1;
+	double hX1 = genZipfH(1.5, s) - 1;
+	double hN = genZipfH(N + 0.5, s);
+	double sq = 2 - genZipfHinv(genZipfH(2.5, s) - exp(-s * log(2.0)), s);
+
+	for (int i=0; i < n; i++) {
+		int k;
+		while (true) {
+			double u = hN + rngDouble() * (hX1 - hN);
+			double x = genZipfHinv(u, s);
+			k = (int) (x + 0.5);
+
+			if (k < 1)
+				k = 1;
+			else if (k > N)
+				k = N;
+
+			if (k - x <= sq || u >= genZipfH(k + 0.5, s) - exp(-s * log((double) k)))
+				break;
+		}
+		out[i] = lo + k - 1;
+	}
+}
+
+#endif
@@ -0,0 +1,224 @@
+/*	Shared random number generator used by all the labs.
+
+	- generator is xoshiro256++ (Blackman, Vigna), seeded through splitmix64
+	- the state is thread_local, so every thread draws from its own
+	  stream and parallel code never contends on a global like rand()
+	- rngSeed(seed) seeds the calling thread; rngSeedThread(seed, id)
+	  gives thread id its own stream, 2^128 steps away from the others,
+	  so a run is fully reproducible from a single seed
+	- threads that never seed themselves get the next free stream of the
+	  last seed passed to rngSeed()
+	- rngBounded() uses Lemire's multiply-shift rejection method,
+	  so there is no modulo bias
+
+	compile with -DRNG_SEED=<n> to repeat a benchmark run exactly
+*/
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <ctime>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+
+#ifndef RNG_SEED
+#define RNG_SEED ((uint64_t) time(NULL))
+#endif
+
+// same meaning as the Profiler FillRandomArray flags
+#ifndef UNSORTED
+#define UNSORTED 0
+#define ASCENDING 1
+#define DESCENDING 2
+#endif
+
+typedef struct {
+	uint64_t s[4];
+	bool seeded;
+} RngState;
+
+static thread_local RngState rngState;
+static std::atomic<uint64_t> rngBaseSeed(0);
+static std::atomic<unsigned int> rngNextStream(1);
+
+static inline uint64_t rngRotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t rngNext64Of(RngState *st) {
+	uint64_t *s = st->s;
+	uint64_t result = rngRotl(s[0] + s[3], 23) + s[0];
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rngRotl(s[3], 45);
+
+	return result;
+}
+
+// advances the state by 2^128 steps, used to split streams
+static void rngJump(RngState *st) {
+	static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+		0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+	for (int i=0; i < 4; i++)
+		for (int b=0; b < 64; b++) {
+			if (JUMP[i] & (1ULL << b)) {
+				s0 ^= st->s[0];
+				s1 ^= st->s[1];
+				s2 ^= st->s[2];
+				s3 ^= st->s[3];
+			}
+			rngNext64Of(st);
+		}
+
+	st->s[0] = s0;
+	st->s[1] = s1;
+	st->s[2] = s2;
+	st->s[3] = s3;
+}
+
+static void rngSeedState(RngState *st, uint64_t seed, unsigned int stream) {
+	uint64_t x = seed;
+	for (int i=0; i < 4; i++)
+		st->s[i] = splitmix64(&x);
+
+	for (unsigned int i=0; i < stream; i++)
+		rngJump(st);
+
+	st->seeded = true;
+}
+
+// seeds the calling thread (stream 0) and the base for unseeded threads
+void rngSeed(uint64_t seed) {
+	rngBaseSeed = seed;
+	rngNextStream = 1;
+	rngSeedState(&rngState, seed, 0);
+}
+
+// gives the calling thread its own reproducible stream
+void rngSeedThread(uint64_t seed, unsigned int streamId) {
+	rngSeedState(&rngState, seed, streamId);
+}
+
+static inline RngState* rngLocal() {
+	if (!rngState.seeded)
+		rngSeedState(&rngState, rngBaseSeed, rngNextStream++);
+
+	return &rngState;
+}
+
+uint64_t rngNext64() {
+	return rngNext64Of(rngLocal());
+}
+
+uint32_t rngNext32() {
+	return (uint32_t) (rngNext64() >> 32);
+}
+
+// uniform integer in [0, range), no modulo bias
+uint32_t rngBounded(uint32_t range) {
+	assert(range > 0);
+
+	uint64_t m = (uint64_t) rngNext32() * range;
+	uint32_t low = (uint32_t) m;
+
+	if (low < range) {
+		uint32_t threshold = -range % range;
+		while (low < threshold) {
+			m = (uint64_t) rngNext32() * range;
+			low = (uint32_t) m;
+		}
+	}
+
+	return (uint32_t) (m >> 32);
+}
+
+// uniform integer in [lo, hi]
+int rngRange(int lo, int hi) {
+	assert(lo <= hi);
+	uint32_t span = (uint32_t) ((int64_t) hi - lo + 1);
+
+	if (span == 0)	// the whole 32 bit range
+		return (int) rngNext32();
+
+	return (int) ((int64_t) lo + rngBounded(span));
+}
+
+// uniform double in [0, 1)
+double rngDouble() {
+	return (rngNext64() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Fisher-Yates
+void rngShuffle(int *arr, int n) {
+	for (int i=n-1; i > 0; i--) {
+		int j = rngBounded(i+1);
+		int tmp = arr[i];
+		arr[i] = arr[j];
+		arr[j] = tmp;
+	}
+}
+
+// n distinct values from [lo, hi] in ascending order
+static void rngFillUnique(int *arr, int n, int lo, int hi) {
+	int64_t range = (int64_t) hi - lo + 1;
+	assert(range >= n);
+
+	if (range <= 16 * (int64_t) n) {
+		// selection sampling (Knuth, algorithm S), O(range)
+		int k = 0;
+		for (int64_t v=0; v < range && k < n; v++)
+			if (rngBounded((uint32_t) (range - v)) < (uint32_t) (n - k))
+				arr[k++] = (int) (lo + v);
+		return;
+	}
+
+	// sparse range: draw, sort, drop duplicates, refill the gap
+	int k = 0;
+	while (k < n) {
+		for (int i=k; i < n; i++)
+			arr[i] = rngRange(lo, hi);
+
+		std::sort(arr, arr + n);
+		k = std::unique(arr, arr + n) - arr;
+	}
+}
+
+// drop-in replacement for the Profiler FillRandomArray
+void rngFillArray(int *arr, int n, int lo, int hi, bool unique = false, int sorted = UNSORTED) {
+	if (unique) {
+		rngFillUnique(arr, n, lo, hi);
+		if (sorted == UNSORTED)
+			rngShuffle(arr, n);
+	} else {
+		for (int i=0; i < n; i++)
+			arr[i] = rngRange(lo, hi);
+		if (sorted != UNSORTED)
+			std::sort(arr, arr + n);
+	}
+
+	if (sorted == DESCENDING)
+		std::reverse(arr, arr + n);
+}
+
+void rngFillDoubles(double *arr, int n, double lo, double hi) {
+	for (int i=0; i < n; i++)
+		arr[i] = lo + rngDouble() * (hi - lo);
+}
+
+#endif